@@ -0,0 +1,98 @@
+#include "./calendarBuckets.h"
+#include "../utils/dateTime.h"
+#include <stdexcept>
+
+// 1970-01-01 was a Thursday, three days after the Monday a week starts on.
+#define EPOCH_WEEKDAY_OFFSET 3
+
+static int64_t floorDivide(int64_t value, int64_t divisor) {
+  const int64_t quotient = value / divisor;
+  return quotient * divisor > value ? quotient - 1 : quotient;
+}
+
+int64_t CalendarBuckets::floor(BucketUnit unit, int64_t timestamp) {
+  const int64_t days = floorDivide(timestamp, SECONDS_IN_DAY);
+
+  switch (unit) {
+  case BucketUnit::DAY:
+    return days * SECONDS_IN_DAY;
+  case BucketUnit::WEEK:
+    return (floorDivide(days + EPOCH_WEEKDAY_OFFSET, 7) * 7 -
+            EPOCH_WEEKDAY_OFFSET) *
+           SECONDS_IN_DAY;
+  case BucketUnit::MONTH:
+  case BucketUnit::YEAR: {
+    int64_t year;
+    unsigned month;
+    unsigned day;
+    DateTimeProcessor::civilFromDays(days, year, month, day);
+
+    return DateTimeProcessor::daysFromCivil(
+               year, unit == BucketUnit::MONTH ? month : 1, 1) *
+           SECONDS_IN_DAY;
+  }
+  default:
+    throw invalid_argument("Hour buckets are not calendar aligned");
+  }
+}
+
+int64_t CalendarBuckets::next(BucketUnit unit, int64_t timestamp) {
+  const int64_t start = floor(unit, timestamp);
+
+  switch (unit) {
+  case BucketUnit::DAY:
+    return start + SECONDS_IN_DAY;
+  case BucketUnit::WEEK:
+    return start + 7 * SECONDS_IN_DAY;
+  default: {
+    int64_t year;
+    unsigned month;
+    unsigned day;
+    DateTimeProcessor::civilFromDays(start / SECONDS_IN_DAY, year, month,
+                                     day);
+
+    if (unit == BucketUnit::YEAR || month == 12) {
+      return DateTimeProcessor::daysFromCivil(year + 1, 1, 1) *
+             SECONDS_IN_DAY;
+    }
+
+    return DateTimeProcessor::daysFromCivil(year, month + 1, 1) *
+           SECONDS_IN_DAY;
+  }
+  }
+}
+
+int64_t CalendarBuckets::ceil(BucketUnit unit, int64_t timestamp) {
+  const int64_t start = floor(unit, timestamp);
+  return start == timestamp ? start : next(unit, timestamp);
+}
+
+vector<int64_t> CalendarBuckets::boundaries(BucketUnit unit, int64_t first,
+                                            int64_t last) {
+  vector<int64_t> result{};
+  if (first > last) {
+    return result;
+  }
+
+  result.push_back(floor(unit, first));
+  while (result.back() <= last) {
+    result.push_back(next(unit, result.back()));
+  }
+
+  return result;
+}
+
+string CalendarBuckets::unitToString(BucketUnit unit) {
+  switch (unit) {
+  case BucketUnit::DAY:
+    return "day";
+  case BucketUnit::WEEK:
+    return "week";
+  case BucketUnit::MONTH:
+    return "month";
+  case BucketUnit::YEAR:
+    return "year";
+  default:
+    return "hours";
+  }
+}
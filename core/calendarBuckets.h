@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// HOURS buckets are runs of hoursStep rows; the others follow the UTC
+// calendar whatever rows are present.
+enum class BucketUnit { HOURS, DAY, WEEK, MONTH, YEAR };
+
+// Calendar bucket boundaries in UTC epoch seconds. Weeks start on Monday.
+// Dates are only converted once per bucket, never per row.
+class CalendarBuckets {
+public:
+  // Start of the bucket holding timestamp.
+  static int64_t floor(BucketUnit unit, int64_t timestamp);
+  // Start of the bucket following the one that holds timestamp.
+  static int64_t next(BucketUnit unit, int64_t timestamp);
+  // First bucket start at or after timestamp.
+  static int64_t ceil(BucketUnit unit, int64_t timestamp);
+
+  // Starts of every bucket overlapping [first, last], followed by the end
+  // of the last one.
+  static vector<int64_t> boundaries(BucketUnit unit, int64_t first,
+                                    int64_t last);
+
+  static string unitToString(BucketUnit unit);
+};
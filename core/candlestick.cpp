@@ -1,127 +1,565 @@
 #import "candlestick.h"
+#import "../utils/dateTime.h"
 #import "../utils/fileReader.h"
 #import "../utils/logger.h"
 #include "temperaturePoint.h"
+#include "timeIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
 #include <string>
+#include <thread>
+
+// Rows handed to each worker at the very least, below that a thread
+// costs more than it saves.
+#define MIN_ROWS_PER_THREAD 16384
+
+CandlestickFilter::CandlestickFilter(EULocation _location)
+    : location(_location), hasInterval(false), interval(0, 0),
+      lowestTemperature(-numeric_limits<float>::infinity()),
+      highestTemperature(numeric_limits<float>::infinity()) {}
+
+static float parseTemperature(const string &value) {
+  char *end = nullptr;
+  const float temperature = strtof(value.c_str(), &end);
+
+  if (value.empty() || *end != '\0' || isnan(temperature)) {
+    throw invalid_argument("Invalid temperature range");
+  }
+
+  return temperature;
+}
+
+CandlestickFilter
+CandlestickFilter::compile(const vector<FilterDTO<string>> &filters) {
+  CandlestickFilter filter{};
+
+  for (const FilterDTO<string> &dto : filters) {
+    switch (dto.type) {
+    case FilterType::location:
+      filter.location = LocationEnumProcessor::stringToLocation(dto.value);
+      break;
+    case FilterType::timeRange: {
+      const vector<string> tokens = FileReader::tokenise(dto.value, '|');
+      if (tokens.size() < 2) {
+        throw invalid_argument("Invalid date interval");
+      }
+
+      filter.interval = DateInterval(DateTimeProcessor::parseIso(tokens[0]),
+                                     DateTimeProcessor::parseIso(tokens[1]));
+      filter.hasInterval = true;
+      break;
+    }
+    case FilterType::temperatureRange: {
+      const size_t separator = dto.value.find('|');
+      if (separator == string::npos) {
+        throw invalid_argument("Invalid temperature range");
+      }
+
+      filter.lowestTemperature =
+          parseTemperature(dto.value.substr(0, separator));
+      filter.highestTemperature =
+          parseTemperature(dto.value.substr(separator + 1));
+      if (filter.lowestTemperature > filter.highestTemperature) {
+        throw invalid_argument("Invalid temperature range");
+      }
+      break;
+    }
+    }
+  }
+
+  return filter;
+}
 
 vector<Candlestick> CandlestickDataExtractor::getCandlesticks(
-    const vector<TemperaturePoint> &points,
-    const vector<FilterDTO<string>> &filters, unsigned int hoursStep) {
+    const TemperatureStore &store, const vector<FilterDTO<string>> &filters,
+    unsigned int hoursStep, u_int threads) {
+  return getCandlesticks(store, CandlestickFilter::compile(filters),
+                         hoursStep, BucketUnit::HOURS, threads);
+}
+
+vector<Candlestick> CandlestickDataExtractor::getCandlesticks(
+    const TemperatureStore &store, const vector<FilterDTO<string>> &filters,
+    BucketUnit unit, u_int threads) {
+  return getCandlesticks(store, CandlestickFilter::compile(filters), 1, unit,
+                         threads);
+}
+
+vector<Candlestick> CandlestickDataExtractor::getCandlesticks(
+    const TemperatureStore &store, const CandlestickFilter &filter,
+    u_int hoursStep, BucketUnit unit, u_int threads) {
+  return createCandlesticks(store.getTimestamps(),
+                            store.getColumn(filter.location), filter,
+                            hoursStep, unit, threads);
+}
+
+vector<BucketRange> CandlestickDataExtractor::getBucketRanges(
+    const TimestampColumn &timestamps, size_t rows,
+    const DateInterval *interval, u_int hoursStep, BucketUnit unit) {
+  vector<BucketRange> ranges{};
+  rows = min(rows, timestamps.size());
+
+  if (rows == 0) {
+    return ranges;
+  }
+
+  TimeIndex index{timestamps};
+
+  if (unit == BucketUnit::HOURS) {
+    const size_t step = max(1u, hoursStep);
+    size_t first = 0;
+    size_t last = rows;
+
+    // A bucket is selected by its first row.
+    if (interval != nullptr) {
+      first = (index.lowerBound(interval->start) + step - 1) / step * step;
+      last = min(rows, index.upperBound(interval->end));
+    }
+
+    for (size_t begin = first; begin < last; begin += step) {
+      ranges.emplace_back(timestamps[begin], begin, min(rows, begin + step));
+    }
+
+    return ranges;
+  }
+
+  int64_t first = timestamps[0];
+  int64_t last = timestamps[rows - 1];
+
+  // A calendar bucket is selected by its start.
+  if (interval != nullptr) {
+    first = max(first, CalendarBuckets::ceil(unit, interval->start));
+    last = min(last, interval->end);
+  }
+
+  const vector<int64_t> boundaries =
+      CalendarBuckets::boundaries(unit, first, last);
+  size_t begin = boundaries.empty() ? rows : index.lowerBound(boundaries[0]);
+
+  for (size_t i = 0; i + 1 < boundaries.size() && begin < rows; ++i) {
+    const size_t end = min(rows, index.lowerBound(boundaries[i + 1]));
+    ranges.emplace_back(boundaries[i], begin, end);
+    begin = end;
+  }
+
+  return ranges;
+}
+
+DateInterval CandlestickDataExtractor::getDateInterval(
+    const vector<FilterDTO<string>> &filters) {
+  const CandlestickFilter filter = CandlestickFilter::compile(filters);
+  if (!filter.hasInterval) {
+    throw invalid_argument("Invalid date interval");
+  }
+
+  return filter.interval;
+}
+
+EULocation CandlestickDataExtractor::getLocation(
+    const vector<FilterDTO<string>> &filters) {
   auto *logger = Logger::getInstance(EnvType::PROD);
 
   EULocation location = EULocation::uknown;
-  DateInterval *dateInterval = nullptr;
 
   for (const FilterDTO<string> &filter : filters) {
     if (filter.type == FilterType::location) {
-        logger->log("Filter value: " + filter.value);
+      logger->log("Filter value: " + filter.value);
       location = LocationEnumProcessor::stringToLocation(filter.value);
     }
-
-    if (filter.type == FilterType::timeRange) {
-      vector<string> tokens = FileReader::tokenise(filter.value, '|');
-      dateInterval = new DateInterval(tokens[0], tokens[1]);
-    }
   }
 
-  if (dateInterval == nullptr) {
-    throw invalid_argument("Invalid date interval");
+  return location;
+}
+
+vector<Candlestick> CandlestickDataExtractor::createCandlesticks(
+    const TimestampColumn &timestamps, const TemperatureColumn &temperatures,
+    const CandlestickFilter &filter, u_int hoursStep, BucketUnit unit,
+    u_int threads) {
+  if (threads == 0) {
+    threads = max(1u, thread::hardware_concurrency());
   }
 
-  vector<TemperaturePoint> filteredPoints = filterPoints(points, location);
+  vector<BucketRange> ranges{};
+  if (threads > 1) {
+    ranges = getBucketRanges(timestamps, temperatures.size(),
+                             filter.getInterval(), hoursStep, unit);
+
+    // Only the rows inside the interval are reduced.
+    const size_t rows =
+        ranges.empty() ? 0 : ranges.back().end - ranges.front().begin;
+    threads = min<size_t>(threads, rows / MIN_ROWS_PER_THREAD);
+  }
 
-  vector<Candlestick> candlesticks =
-      createCandlesticks(filteredPoints, dateInterval, hoursStep);
+  if (threads <= 1) {
+    CandlestickAggregator aggregator{filter, hoursStep, unit};
+    aggregator.update(timestamps, temperatures);
 
-  delete dateInterval;
+    return aggregator.getCandlesticks();
+  }
 
-  return candlesticks;
+  return createParallel(temperatures, ranges, filter, threads);
 }
 
-vector<Candlestick> CandlestickDataExtractor::createCandlesticks(
-    const vector<TemperaturePoint> &filteredPoints, DateInterval *dateInterval,
-    u_int hoursStep) {
+vector<Candlestick>
+CandlestickDataExtractor::createParallel(const TemperatureColumn &temperatures,
+                                         const vector<BucketRange> &ranges,
+                                         const CandlestickFilter &filter,
+                                         u_int threads) {
+  // Buckets only depend on each other through open, so workers reduce
+  // disjoint runs of buckets and the chaining is done afterwards. Workers
+  // are started per call instead of kept in a pool: each one gets at least
+  // MIN_ROWS_PER_THREAD rows, which outweighs starting a thread.
+  vector<FloatSummary> buckets(ranges.size());
+  vector<thread> workers{};
+  const size_t chunkSize = (ranges.size() + threads - 1) / threads;
+
+  for (u_int i = 0; i < threads; ++i) {
+    const size_t first = min(ranges.size(), i * chunkSize);
+    const size_t last = min(ranges.size(), first + chunkSize);
+
+    workers.emplace_back([&temperatures, &ranges, &filter, &buckets, first,
+                          last]() {
+      for (size_t bucket = first; bucket < last; ++bucket) {
+        buckets[bucket] = summarize(
+            temperatures, ranges[bucket].begin, ranges[bucket].end,
+            filter.lowestTemperature, filter.highestTemperature);
+      }
+    });
+  }
+
+  for (thread &worker : workers) {
+    worker.join();
+  }
+
   vector<Candlestick> candlesticks{};
+  float carriedOpen = 0;
 
-  for (unsigned int i = 0; i < filteredPoints.size(); i += hoursStep) {
-    const TemperaturePoint &point = filteredPoints[i];
-    float initial = point.getTemperature();
-    float open;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    appendCandlestick(candlesticks, carriedOpen, ranges[i].timestamp,
+                      buckets[i]);
+  }
 
-    if (open == 0) {
-      open = initial;
+  return candlesticks;
+}
+
+map<EULocation, vector<Candlestick>>
+CandlestickDataExtractor::getLocationCandlesticks(
+    const TemperatureStore &store, const vector<EULocation> &locations,
+    const DateInterval *interval, u_int hoursStep, BucketUnit unit,
+    u_int threads) {
+  vector<EULocation> selected = locations;
+
+  if (selected.empty()) {
+    for (size_t location = 0; location < LOCATIONS_AMOUNT; ++location) {
+      if (store.isLoaded(EULocation(location))) {
+        selected.push_back(EULocation(location));
+      }
     }
+  }
+
+  const vector<BucketRange> ranges = getBucketRanges(
+      store.getTimestamps(), store.size(), interval, hoursStep, unit);
+
+  map<EULocation, vector<Candlestick>> result{};
+  vector<const TemperatureColumn *> columns{};
+  vector<vector<Candlestick> *> series{};
+
+  for (EULocation location : selected) {
+    columns.push_back(&store.getColumn(location));
+    series.push_back(&result[location]);
+    series.back()->reserve(ranges.size());
+  }
 
-    float high = initial;
-    float low = initial;
-    float close = 0;
+  if (threads == 0) {
+    threads = max(1u, thread::hardware_concurrency());
+  }
+
+  threads = max<size_t>(1, min<size_t>(threads, selected.size()));
 
-    string date = point.getDate();
+  // Bucket by bucket, each worker reduces its share of the columns, so
+  // the rows of one bucket are read together across locations.
+  auto sweep = [&ranges, &columns, &series, threads](u_int worker) {
+    vector<float> carriedOpen(columns.size(), 0);
 
-    if (dateInterval != nullptr) {
-      if (date < dateInterval->start || date > dateInterval->end) {
-        continue;
+    for (const BucketRange &range : ranges) {
+      for (size_t i = worker; i < columns.size(); i += threads) {
+        appendCandlestick(*series[i], carriedOpen[i], range.timestamp,
+                          summarize(*columns[i], range.begin, range.end));
       }
     }
+  };
+
+  vector<thread> workers{};
+  for (u_int worker = 1; worker < threads; ++worker) {
+    workers.emplace_back(sweep, worker);
+  }
+
+  sweep(0);
+
+  for (thread &worker : workers) {
+    worker.join();
+  }
+
+  return result;
+}
+
+void CandlestickDataExtractor::appendCandlestick(
+    vector<Candlestick> &candlesticks, float &carriedOpen, int64_t timestamp,
+    const FloatSummary &bucket) {
+  if (bucket.count == 0) {
+    return;
+  }
+
+  const float close = getClose(bucket);
+  const float open = carriedOpen == 0 ? bucket.first : carriedOpen;
+
+  candlesticks.emplace_back(timestamp, open, bucket.highest, bucket.lowest,
+                            close);
+  carriedOpen = close;
+}
+
+CandlestickAggregator::CandlestickAggregator(EULocation _location,
+                                             const DateInterval *_interval,
+                                             u_int _hoursStep,
+                                             BucketUnit _unit)
+    : location(_location), interval(0, 0), hasInterval(_interval != nullptr),
+      hoursStep(max(1u, _hoursStep)), unit(_unit),
+      lowestTemperature(-numeric_limits<float>::infinity()),
+      highestTemperature(numeric_limits<float>::infinity()), processedRows(0),
+      carriedOpen(0), bucketSelected(false), bucketEmitted(false),
+      bucketTimestamp(0), bucketBoundary(numeric_limits<int64_t>::min()) {
+  if (_interval != nullptr) {
+    interval = *_interval;
+  }
+}
 
-    for (unsigned int j = i; j < i + hoursStep; j++) {
-      const TemperaturePoint &everyTimePoint = filteredPoints[j];
+CandlestickAggregator::CandlestickAggregator(
+    const vector<FilterDTO<string>> &filters, u_int _hoursStep,
+    BucketUnit _unit)
+    : CandlestickAggregator(CandlestickFilter::compile(filters), _hoursStep,
+                            _unit) {}
+
+CandlestickAggregator::CandlestickAggregator(const CandlestickFilter &filter,
+                                             u_int _hoursStep,
+                                             BucketUnit _unit)
+    : CandlestickAggregator(filter.location, filter.getInterval(), _hoursStep,
+                            _unit) {
+  lowestTemperature = filter.lowestTemperature;
+  highestTemperature = filter.highestTemperature;
+}
+
+void CandlestickAggregator::update(const TemperatureStore &store) {
+  update(store.getTimestamps(), store.getColumn(location));
+}
 
-      close += everyTimePoint.getTemperature();
+void CandlestickAggregator::update(const TimestampColumn &timestamps,
+                                   const TemperatureColumn &temperatures) {
+  if (unit != BucketUnit::HOURS) {
+    updateCalendar(timestamps, temperatures);
+    return;
+  }
+
+  size_t row = processedRows;
+  size_t rows = temperatures.size();
+
+  // Buckets are selected by their first row, so only buckets starting in
+  // [first, last) can be selected and the rows around them are skipped.
+  if (hasInterval) {
+    TimeIndex index{timestamps};
+    const size_t first =
+        (index.lowerBound(interval.start) + hoursStep - 1) / hoursStep *
+        hoursStep;
+    const size_t last = index.upperBound(interval.end);
+    const size_t end = min<size_t>(
+        rows, (last + hoursStep - 1) / hoursStep * hoursStep);
+
+    if (row < first) {
+      skipTo(min(first, rows));
+      row = processedRows;
+    }
+
+    rows = max(row, end);
+  }
+
+  while (row < rows) {
+    if (row % hoursStep == 0) {
+      finishBucket();
+      startBucket(timestamps[row]);
+    }
+
+    const size_t bucketEnd =
+        min<size_t>(temperatures.size(), (row / hoursStep + 1) * hoursStep);
+
+    if (bucketSelected) {
+      bucket.merge(CandlestickDataExtractor::summarize(
+          temperatures, row, bucketEnd, lowestTemperature,
+          highestTemperature));
+    }
+
+    row = bucketEnd;
+  }
+
+  processedRows = row;
+
+  // The last bucket may still grow, publish what it holds so far.
+  writeBucket();
+
+  if (rows < temperatures.size()) {
+    skipTo(temperatures.size());
+  }
+}
+
+void CandlestickAggregator::updateCalendar(
+    const TimestampColumn &timestamps, const TemperatureColumn &temperatures) {
+  size_t row = processedRows;
+  size_t rows = temperatures.size();
+
+  // Buckets are selected by their start, so rows before the first bucket
+  // starting in the interval and after the bucket holding its end are
+  // skipped.
+  if (hasInterval) {
+    TimeIndex index{timestamps};
+    const size_t first =
+        index.lowerBound(CalendarBuckets::ceil(unit, interval.start));
+    const size_t end =
+        index.lowerBound(CalendarBuckets::next(unit, interval.end));
+
+    if (row < first) {
+      skipTo(min(first, rows));
+      row = processedRows;
+    }
 
-      if (j >= filteredPoints.size()) {
-        break;
+    rows = max(row, min(rows, end));
+  }
+
+  if (row < rows) {
+    const vector<int64_t> boundaries =
+        CalendarBuckets::boundaries(unit, timestamps[row], timestamps[rows - 1]);
+    size_t boundary = 0;
+
+    while (row < rows) {
+      // Gaps simply move the row into a later bucket, empty buckets in
+      // between are never started.
+      if (timestamps[row] >= bucketBoundary) {
+        finishBucket();
+
+        while (boundaries[boundary + 1] <= timestamps[row]) {
+          ++boundary;
+        }
+
+        startBucket(boundaries[boundary]);
+        bucketBoundary = boundaries[boundary + 1];
       }
 
-      if (everyTimePoint.getTemperature() > high) {
-        high = everyTimePoint.getTemperature();
+      size_t bucketEnd = row;
+      while (bucketEnd < rows && timestamps[bucketEnd] < bucketBoundary) {
+        ++bucketEnd;
       }
 
-      if (everyTimePoint.getTemperature() < low) {
-        low = everyTimePoint.getTemperature();
+      if (bucketSelected) {
+        bucket.merge(CandlestickDataExtractor::summarize(
+          temperatures, row, bucketEnd, lowestTemperature,
+          highestTemperature));
       }
+
+      row = bucketEnd;
     }
+  }
 
-    close /= hoursStep;
+  processedRows = row;
+  writeBucket();
 
-    if (i == 0 && close == 0) {
-      close = point.getTemperature();
-    }
+  if (rows < temperatures.size()) {
+    skipTo(temperatures.size());
+  }
+}
 
-    candlesticks.emplace_back(date, open, high, low, close);
-    open = close;
+void CandlestickAggregator::skipTo(size_t row) {
+  // Skipped rows belong to unselected buckets; the bucket in progress is
+  // closed so later rows cannot land in it.
+  finishBucket();
+  bucketSelected = false;
+  bucketBoundary = numeric_limits<int64_t>::min();
+  processedRows = row;
+}
+
+void CandlestickAggregator::startBucket(int64_t timestamp) {
+  bucketSelected = !hasInterval ||
+                   (timestamp >= interval.start && timestamp <= interval.end);
+  bucketEmitted = false;
+  bucketTimestamp = timestamp;
+  bucket = FloatSummary{};
+}
+
+void CandlestickAggregator::finishBucket() {
+  if (!bucketSelected || bucket.count == 0) {
+    return;
   }
 
-  return candlesticks;
+  writeBucket();
+  carriedOpen = candlesticks.back().close;
+  bucketSelected = false;
 }
 
-vector<TemperaturePoint>
-CandlestickDataExtractor::filterPoints(const vector<TemperaturePoint> &points,
-                                       const EULocation &location) {
-  vector<TemperaturePoint> filteredPoints{};
+void CandlestickAggregator::writeBucket() {
+  if (!bucketSelected || bucket.count == 0) {
+    return;
+  }
 
-  for (const TemperaturePoint &point : points) {
-    if (point.getLocation() != location) {
-      continue;
-    }
+  const float close = CandlestickDataExtractor::getClose(bucket);
 
-    filteredPoints.emplace_back(point);
+  if (!bucketEmitted) {
+    const float open = carriedOpen == 0 ? bucket.first : carriedOpen;
+    candlesticks.emplace_back(bucketTimestamp, open, bucket.highest,
+                              bucket.lowest, close);
+    bucketEmitted = true;
+    return;
   }
 
+  Candlestick &candlestick = candlesticks.back();
+  candlestick.high = bucket.highest;
+  candlestick.low = bucket.lowest;
+  candlestick.close = close;
+}
+
+FloatSummary
+CandlestickDataExtractor::summarize(const TemperatureColumn &temperatures,
+                                    size_t begin, size_t end) {
+  end = min(end, temperatures.size());
+  if (begin >= end) {
+    return FloatSummary{};
+  }
 
-  return filteredPoints;
+  return SimdReduction::summarize(temperatures.data() + begin, end - begin);
 }
 
-vector<Candlestick> CandlestickDataExtractor::getCandlesticks(
-    const vector<TemperaturePoint> &points, unsigned int hoursStep,
-    EULocation location) {
+FloatSummary CandlestickDataExtractor::summarize(
+    const TemperatureColumn &temperatures, size_t begin, size_t end,
+    float lowest, float highest) {
+  end = min(end, temperatures.size());
+  if (begin >= end) {
+    return FloatSummary{};
+  }
 
-  auto *logger = Logger::getInstance(EnvType::PROD);
+  return SimdReduction::summarize(temperatures.data() + begin, end - begin,
+                                  lowest, highest);
+}
 
-  vector<TemperaturePoint> filteredPoints = filterPoints(points, location);
+// The sum is kept in double, so the mean is nearly independent of how the
+// bucket was split between updates or threads: the order of the additions
+// can still change the last bits.
+float CandlestickDataExtractor::getClose(const FloatSummary &bucket) {
+  return static_cast<float>(bucket.sum / bucket.count);
+}
 
+vector<Candlestick> CandlestickDataExtractor::getCandlesticks(
+    const TemperatureStore &store, unsigned int hoursStep,
+    EULocation location, u_int threads) {
   vector<Candlestick> paginatedCandlesticks =
-      createCandlesticks(filteredPoints, nullptr, hoursStep);
+      createCandlesticks(store.getTimestamps(), store.getColumn(location),
+                         CandlestickFilter{location}, hoursStep,
+                         BucketUnit::HOURS, threads);
 
   return paginatedCandlesticks;
 }
@@ -136,25 +574,36 @@ float CandlestickProcessor::getAverageMean(
   return sum / candlesticks.size();
 }
 
-float CandlestickProcessor::getLowest(const vector<Candlestick> &candlesticks) {
-  float lowest = candlesticks[0].low;
-  for (const Candlestick &candlestick : candlesticks) {
-    if (candlestick.low < lowest) {
-      lowest = candlestick.low;
-    }
+void CandlestickProcessor::getBounds(const vector<Candlestick> &candlesticks,
+                                     float &lowest, float &highest) {
+  getBounds(candlesticks, 0, candlesticks.size(), lowest, highest);
+}
+
+void CandlestickProcessor::getBounds(const vector<Candlestick> &candlesticks,
+                                     size_t begin, size_t end, float &lowest,
+                                     float &highest) {
+  lowest = candlesticks[begin].low;
+  highest = candlesticks[begin].high;
+
+  for (size_t i = begin + 1; i < end; ++i) {
+    lowest = min(lowest, candlesticks[i].low);
+    highest = max(highest, candlesticks[i].high);
   }
+}
+
+float CandlestickProcessor::getLowest(const vector<Candlestick> &candlesticks) {
+  float lowest;
+  float highest;
+  getBounds(candlesticks, lowest, highest);
 
   return lowest;
 }
 
 float CandlestickProcessor::getHighest(
     const vector<Candlestick> &candlesticks) {
-  float highest = candlesticks[0].high;
-  for (const Candlestick &candlestick : candlesticks) {
-    if (candlestick.high > highest) {
-      highest = candlestick.high;
-    }
-  }
+  float lowest;
+  float highest;
+  getBounds(candlesticks, lowest, highest);
 
   return highest;
 }
@@ -1,51 +1,210 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
 #include <string>
 #include <vector>
 
 #include "../ui/menu/menu.h"
+#include "../utils/simdReduction.h"
+#include "./calendarBuckets.h"
 #include "./temperaturePoint.h"
 
 using namespace std;
 
 class Candlestick {
 public:
-  string date;
+  // Bucket start in UTC epoch seconds, see DateTimeProcessor.
+  int64_t timestamp;
   float open;
   float high;
   float close;
   float low;
 
-  Candlestick(string _date, float _open, float _high, float _low, float _close)
-      : date(_date), open(_open), high(_high), low(_low), close(_close) {}
+  Candlestick(int64_t _timestamp, float _open, float _high, float _low,
+              float _close)
+      : timestamp(_timestamp), open(_open), high(_high), low(_low),
+        close(_close) {}
 };
 
 class DateInterval {
 public:
-  string start;
-  string end;
-  DateInterval(string _start, string _end) : start(_start), end(_end) {}
+  int64_t start;
+  int64_t end;
+  DateInterval(int64_t _start, int64_t _end) : start(_start), end(_end) {}
+};
+
+// Filters parsed once into typed values. The location and interval pick
+// the rows; the temperature range is tested per reading inside the bucket
+// reduction, the same pass that skips missing readings.
+class CandlestickFilter {
+public:
+  CandlestickFilter(EULocation _location = EULocation::uknown);
+
+  // Throws invalid_argument on a malformed time or temperature range.
+  static CandlestickFilter compile(const vector<FilterDTO<string>> &filters);
+
+  EULocation location;
+  bool hasInterval;
+  DateInterval interval;
+  float lowestTemperature;
+  float highestTemperature;
+
+  const DateInterval *getInterval() const {
+    return hasInterval ? &interval : nullptr;
+  }
+  // Whether the temperature range drops any reading of a column whose
+  // readings lie in [lowest, highest].
+  bool excludes(float lowest, float highest) const {
+    return lowest < lowestTemperature || highest > highestTemperature;
+  }
+};
+
+// Rows [begin, end) of the bucket that starts at timestamp.
+class BucketRange {
+public:
+  int64_t timestamp;
+  size_t begin;
+  size_t end;
+  BucketRange(int64_t _timestamp, size_t _begin, size_t _end)
+      : timestamp(_timestamp), begin(_begin), end(_end) {}
 };
 
 class CandlestickDataExtractor {
 public:
+  // threads > 1 reduces the buckets in parallel, 0 picks the hardware
+  // concurrency. The result does not depend on the thread count.
   static vector<Candlestick>
-  getCandlesticks(const vector<TemperaturePoint> &points,
+  getCandlesticks(const TemperatureStore &store,
                   const vector<FilterDTO<string>> &filters,
-                  unsigned int hoursStep = 24);
+                  unsigned int hoursStep = 24, u_int threads = 1);
 
   static vector<Candlestick>
-  getCandlesticks(const vector<TemperaturePoint> &points,
+  getCandlesticks(const TemperatureStore &store,
                   unsigned int hoursStep = 24,
-                  EULocation location = EULocation::de);
+                  EULocation location = EULocation::de, u_int threads = 1);
+
+  // Calendar-aligned candlesticks, one per day, week, month or year.
+  static vector<Candlestick>
+  getCandlesticks(const TemperatureStore &store,
+                  const vector<FilterDTO<string>> &filters, BucketUnit unit,
+                  u_int threads = 1);
+
+  // hoursStep is only used by HOURS buckets.
+  static vector<Candlestick> getCandlesticks(const TemperatureStore &store,
+                                             const CandlestickFilter &filter,
+                                             u_int hoursStep, BucketUnit unit,
+                                             u_int threads = 1);
+
+  // Candlesticks of each of locations, every loaded one when it is empty.
+  // The buckets are found once and every column is reduced in the same
+  // sweep over them; threads > 1 splits the locations between workers.
+  static map<EULocation, vector<Candlestick>>
+  getLocationCandlesticks(const TemperatureStore &store,
+                          const vector<EULocation> &locations,
+                          const DateInterval *interval, u_int hoursStep,
+                          BucketUnit unit = BucketUnit::HOURS,
+                          u_int threads = 1);
+
+  // Selected buckets over the first rows of timestamps, in order. Only
+  // the buckets inside the interval are visited.
+  static vector<BucketRange> getBucketRanges(const TimestampColumn &timestamps,
+                                             size_t rows,
+                                             const DateInterval *interval,
+                                             u_int hoursStep, BucketUnit unit);
+
+  // Present readings of rows [begin, end), reduced in one vectorized pass.
+  static FloatSummary summarize(const TemperatureColumn &temperatures,
+                                size_t begin, size_t end);
+  // Same, counting only the readings in [lowest, highest].
+  static FloatSummary summarize(const TemperatureColumn &temperatures,
+                                size_t begin, size_t end, float lowest,
+                                float highest);
+  static float getClose(const FloatSummary &bucket);
+
+  static EULocation getLocation(const vector<FilterDTO<string>> &filters);
+  static DateInterval
+  getDateInterval(const vector<FilterDTO<string>> &filters);
 
 private:
-  static vector<TemperaturePoint> filterPoints(const vector<TemperaturePoint> &points, const EULocation &location);
   static vector<Candlestick>
-  createCandlesticks(const vector<TemperaturePoint> &filteredPoints,
-                     DateInterval *dateInterval, u_int hoursStep);
+  createCandlesticks(const TimestampColumn &timestamps,
+                     const TemperatureColumn &temperatures,
+                     const CandlestickFilter &filter, u_int hoursStep,
+                     BucketUnit unit = BucketUnit::HOURS, u_int threads = 1);
+  static vector<Candlestick>
+  createParallel(const TemperatureColumn &temperatures,
+                 const vector<BucketRange> &ranges,
+                 const CandlestickFilter &filter, u_int threads);
+  // Appends the candlestick of a reduced bucket, empty ones are skipped.
+  static void appendCandlestick(vector<Candlestick> &candlesticks,
+                                float &carriedOpen, int64_t timestamp,
+                                const FloatSummary &bucket);
+};
+
+// Incremental form of createCandlesticks. update() folds in only the rows
+// appended since the previous call: the still-open last bucket is rewritten
+// in place and new buckets are appended, so follow mode never rescans the
+// history. With a calendar unit rows go to the day, week, month or year
+// their timestamp falls in and each candlestick is stamped with its start.
+class CandlestickAggregator {
+public:
+  CandlestickAggregator(EULocation _location, const DateInterval *_interval,
+                        u_int _hoursStep,
+                        BucketUnit _unit = BucketUnit::HOURS);
+  CandlestickAggregator(const vector<FilterDTO<string>> &filters,
+                        u_int _hoursStep,
+                        BucketUnit _unit = BucketUnit::HOURS);
+  CandlestickAggregator(const CandlestickFilter &filter, u_int _hoursStep,
+                        BucketUnit _unit = BucketUnit::HOURS);
+
+  void update(const TemperatureStore &store);
+  void update(const TimestampColumn &timestamps,
+              const TemperatureColumn &temperatures);
+
+  const vector<Candlestick> &getCandlesticks() const { return candlesticks; }
+  EULocation getLocation() const { return location; }
+  size_t getProcessedRows() const { return processedRows; }
+
+private:
+  EULocation location;
+  DateInterval interval;
+  bool hasInterval;
+  u_int hoursStep;
+  BucketUnit unit;
+  float lowestTemperature;
+  float highestTemperature;
+
+  vector<Candlestick> candlesticks;
+  size_t processedRows;
+
+  // Close of the last finished bucket, the next bucket opens at it.
+  float carriedOpen;
+
+  // State of the bucket that is still receiving rows.
+  bool bucketSelected;
+  bool bucketEmitted;
+  int64_t bucketTimestamp;
+  // Start of the next calendar bucket.
+  int64_t bucketBoundary;
+  FloatSummary bucket;
+
+  void updateCalendar(const TimestampColumn &timestamps,
+                      const TemperatureColumn &temperatures);
+  void startBucket(int64_t timestamp);
+  void skipTo(size_t row);
+  void finishBucket();
+  void writeBucket();
 };
 
 class CandlestickProcessor {
 public:
+  // Lowest low and highest high in a single pass.
+  static void getBounds(const vector<Candlestick> &candlesticks, float &lowest,
+                        float &highest);
+  // Same over candlesticks [begin, end), which must not be empty.
+  static void getBounds(const vector<Candlestick> &candlesticks, size_t begin,
+                        size_t end, float &lowest, float &highest);
   static float getAverageMean(const vector<Candlestick> &candlesticks);
   static float getLowest(const vector<Candlestick> &candlesticks);
   static float getHighest(const vector<Candlestick> &candlesticks);
@@ -0,0 +1,66 @@
+#include "./candlestickCache.h"
+#include <tuple>
+
+bool CandlestickQuery::operator<(const CandlestickQuery &other) const {
+  return tie(location, start, end, lowestTemperature, highestTemperature,
+             hoursStep, unit, version) <
+         tie(other.location, other.start, other.end, other.lowestTemperature,
+             other.highestTemperature, other.hoursStep, other.unit,
+             other.version);
+}
+
+const vector<Candlestick> *
+CandlestickCache::find(const CandlestickQuery &query) {
+  auto found = index.find(query);
+  if (found == index.end()) {
+    ++misses;
+    return nullptr;
+  }
+
+  ++hits;
+  entries.splice(entries.begin(), entries, found->second);
+
+  return &found->second->second;
+}
+
+void CandlestickCache::insert(const CandlestickQuery &query,
+                              const vector<Candlestick> &candlesticks) {
+  const size_t size = entryBytes(candlesticks);
+  if (size > capacity) {
+    return;
+  }
+
+  auto found = index.find(query);
+  if (found != index.end()) {
+    bytes -= entryBytes(found->second->second);
+    entries.erase(found->second);
+    index.erase(found);
+  }
+
+  entries.emplace_front(query, candlesticks);
+  index[query] = entries.begin();
+  bytes += size;
+
+  evict();
+}
+
+void CandlestickCache::clear() {
+  entries.clear();
+  index.clear();
+  bytes = 0;
+}
+
+// The candlesticks plus the list node, key and map node around them.
+size_t CandlestickCache::entryBytes(const vector<Candlestick> &candlesticks) {
+  return candlesticks.size() * sizeof(Candlestick) + sizeof(Entry) +
+         sizeof(CandlestickQuery) + 4 * sizeof(void *);
+}
+
+void CandlestickCache::evict() {
+  while (bytes > capacity && !entries.empty()) {
+    const Entry &last = entries.back();
+    bytes -= entryBytes(last.second);
+    index.erase(last.first);
+    entries.pop_back();
+  }
+}
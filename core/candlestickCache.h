@@ -0,0 +1,78 @@
+#pragma once
+
+#include "./calendarBuckets.h"
+#include "./candlestick.h"
+#include "./temperaturePoint.h"
+#include <cstdint>
+#include <list>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+#define DEFAULT_CANDLESTICK_CACHE_BYTES (16 * 1024 * 1024)
+
+// Everything a candlestick result depends on. hoursStep only matters for
+// HOURS buckets; version is TemperatureStore::getVersion, so appended or
+// reloaded rows never hit an older result.
+class CandlestickQuery {
+public:
+  CandlestickQuery(const CandlestickFilter &filter, u_int _hoursStep,
+                   BucketUnit _unit, uint64_t _version)
+      : location(filter.location),
+        start(filter.hasInterval ? filter.interval.start : INT64_MIN),
+        end(filter.hasInterval ? filter.interval.end : INT64_MAX),
+        lowestTemperature(filter.lowestTemperature),
+        highestTemperature(filter.highestTemperature),
+        hoursStep(_unit == BucketUnit::HOURS ? _hoursStep : 0), unit(_unit),
+        version(_version) {}
+
+  EULocation location;
+  int64_t start;
+  int64_t end;
+  float lowestTemperature;
+  float highestTemperature;
+  u_int hoursStep;
+  BucketUnit unit;
+  uint64_t version;
+
+  bool operator<(const CandlestickQuery &other) const;
+};
+
+// Least recently used cache of candlestick results, bounded by the bytes
+// the cached candlesticks take. Menu navigation redraws with the same
+// query, so most frames are served from here.
+class CandlestickCache {
+public:
+  CandlestickCache(size_t _capacity = DEFAULT_CANDLESTICK_CACHE_BYTES)
+      : capacity(_capacity), bytes(0), hits(0), misses(0) {}
+
+  // Cached result of query, nullptr on a miss. A hit becomes the most
+  // recently used entry.
+  const vector<Candlestick> *find(const CandlestickQuery &query);
+  // Results larger than the whole capacity are not kept.
+  void insert(const CandlestickQuery &query,
+              const vector<Candlestick> &candlesticks);
+  void clear();
+
+  size_t getCapacity() const { return capacity; }
+  size_t getBytes() const { return bytes; }
+  size_t getEntries() const { return entries.size(); }
+  size_t getHits() const { return hits; }
+  size_t getMisses() const { return misses; }
+
+private:
+  typedef pair<CandlestickQuery, vector<Candlestick>> Entry;
+
+  // Most recently used first.
+  list<Entry> entries;
+  map<CandlestickQuery, list<Entry>::iterator> index;
+
+  size_t capacity;
+  size_t bytes;
+  size_t hits;
+  size_t misses;
+
+  static size_t entryBytes(const vector<Candlestick> &candlesticks);
+  void evict();
+};
@@ -0,0 +1,64 @@
+#include "./candlestickRangeIndex.h"
+#include <algorithm>
+
+CandlestickRangeIndex::CandlestickRangeIndex() {}
+
+void CandlestickRangeIndex::update(const TemperatureColumn &temperatures) {
+  table.update(temperatures);
+}
+
+FloatSummary
+CandlestickRangeIndex::query(const TemperatureColumn &temperatures,
+                             size_t begin, size_t end) const {
+  return table.query(temperatures, begin, end);
+}
+
+vector<Candlestick> CandlestickRangeIndex::getCandlesticks(
+    const TimestampColumn &timestamps, const TemperatureColumn &temperatures,
+    const DateInterval *interval, u_int hoursStep) const {
+  const size_t rows = min(getProcessedRows(), temperatures.size());
+
+  return getCandlesticks(temperatures,
+                         CandlestickDataExtractor::getBucketRanges(
+                             timestamps, rows, interval, hoursStep,
+                             BucketUnit::HOURS));
+}
+
+vector<Candlestick> CandlestickRangeIndex::getCandlesticks(
+    const TimestampColumn &timestamps, const TemperatureColumn &temperatures,
+    const DateInterval *interval, BucketUnit unit) const {
+  const size_t rows = min(getProcessedRows(), temperatures.size());
+
+  return getCandlesticks(temperatures,
+                         CandlestickDataExtractor::getBucketRanges(
+                             timestamps, rows, interval, 1, unit));
+}
+
+vector<Candlestick>
+CandlestickRangeIndex::getCandlesticks(
+    const TemperatureColumn &temperatures,
+    const vector<BucketRange> &ranges) const {
+  vector<Candlestick> candlesticks{};
+  float carriedOpen = 0;
+
+  for (const BucketRange &range : ranges) {
+    emit(candlesticks, carriedOpen, range.timestamp,
+         query(temperatures, range.begin, range.end));
+  }
+
+  return candlesticks;
+}
+
+void CandlestickRangeIndex::emit(vector<Candlestick> &candlesticks,
+                                 float &carriedOpen, int64_t timestamp,
+                                 const FloatSummary &node) {
+  if (node.count == 0) {
+    return;
+  }
+
+  const float close = CandlestickDataExtractor::getClose(node);
+  const float open = carriedOpen == 0 ? node.first : carriedOpen;
+
+  candlesticks.emplace_back(timestamp, open, node.highest, node.lowest, close);
+  carriedOpen = close;
+}
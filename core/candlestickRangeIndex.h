@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../utils/simdReduction.h"
+#include "./calendarBuckets.h"
+#include "./candlestick.h"
+#include "./rangeQueryTable.h"
+#include "./temperaturePoint.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Candlesticks of one location column answered from its RangeQueryTable.
+// Every bucket, whatever its size or alignment, is one constant time query
+// instead of a pass over its rows.
+class CandlestickRangeIndex {
+public:
+  CandlestickRangeIndex();
+
+  // Folds in the rows appended since the previous call.
+  void update(const TemperatureColumn &temperatures);
+
+  // Same buckets, selection and open/close rules as CandlestickAggregator.
+  vector<Candlestick> getCandlesticks(const TimestampColumn &timestamps,
+                                      const TemperatureColumn &temperatures,
+                                      const DateInterval *interval,
+                                      u_int hoursStep) const;
+  // Calendar buckets; each one costs a time index lookup.
+  vector<Candlestick> getCandlesticks(const TimestampColumn &timestamps,
+                                      const TemperatureColumn &temperatures,
+                                      const DateInterval *interval,
+                                      BucketUnit unit) const;
+
+  // Aggregate of rows [begin, end), which must already be folded in.
+  FloatSummary query(const TemperatureColumn &temperatures, size_t begin,
+                      size_t end) const;
+
+  size_t getProcessedRows() const { return table.getProcessedRows(); }
+
+private:
+  RangeQueryTable table;
+
+  vector<Candlestick> getCandlesticks(const TemperatureColumn &temperatures,
+                                      const vector<BucketRange> &ranges) const;
+  static void emit(vector<Candlestick> &candlesticks, float &carriedOpen,
+                   int64_t timestamp, const FloatSummary &node);
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// Storage of one ColumnStore column. It either owns its values or views
+// memory kept alive by a shared owner, e.g. a mapped snapshot, so a column
+// can be read in place without copying it. The first write copies a view
+// into owned storage.
+template <typename T> class ColumnBuffer {
+public:
+  typedef T value_type;
+  typedef const T *const_iterator;
+
+  ColumnBuffer() : values(nullptr), count(0) {}
+  ColumnBuffer(vector<T> &&_owned) : owned(move(_owned)) { sync(); }
+
+  ColumnBuffer(const ColumnBuffer &other)
+      : owned(other.owned), owner(other.owner) {
+    adoptFrom(other);
+  }
+  ColumnBuffer(ColumnBuffer &&other)
+      : owned(move(other.owned)), owner(move(other.owner)) {
+    adoptFrom(other);
+    other.clear();
+  }
+
+  ColumnBuffer &operator=(ColumnBuffer other) {
+    owned.swap(other.owned);
+    owner.swap(other.owner);
+    adoptFrom(other);
+    return *this;
+  }
+
+  // values must stay valid for as long as _owner is alive.
+  void view(const T *_values, size_t _count,
+            const shared_ptr<const void> &_owner) {
+    vector<T>().swap(owned);
+    owner = _owner;
+    values = _values;
+    count = _count;
+  }
+  bool isView() const { return owner != nullptr; }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  const T *data() const { return values; }
+  const T *begin() const { return values; }
+  const T *end() const { return values + count; }
+  const T &operator[](size_t i) const { return values[i]; }
+  const T &front() const { return values[0]; }
+  const T &back() const { return values[count - 1]; }
+
+  void push_back(const T &value) {
+    own();
+    owned.push_back(value);
+    sync();
+  }
+
+  template <typename Iterator> void append(Iterator first, Iterator last) {
+    own();
+    owned.insert(owned.end(), first, last);
+    sync();
+  }
+
+  void reserve(size_t rows) {
+    own();
+    owned.reserve(rows);
+    sync();
+  }
+
+  void clear() {
+    vector<T>().swap(owned);
+    owner.reset();
+    sync();
+  }
+
+  bool operator==(const ColumnBuffer &other) const {
+    return count == other.count && equal(begin(), end(), other.begin());
+  }
+  bool operator!=(const ColumnBuffer &other) const {
+    return !(*this == other);
+  }
+
+private:
+  vector<T> owned;
+  shared_ptr<const void> owner;
+  const T *values;
+  size_t count;
+
+  void sync() {
+    values = owned.data();
+    count = owned.size();
+  }
+
+  // Called once owned and owner are taken over from other.
+  void adoptFrom(const ColumnBuffer &other) {
+    if (owner) {
+      values = other.values;
+      count = other.count;
+    } else {
+      sync();
+    }
+  }
+
+  void own() {
+    if (owner) {
+      owned.assign(values, values + count);
+      owner.reset();
+      sync();
+    }
+  }
+};
+
+typedef ColumnBuffer<int64_t> TimestampColumn;
+typedef ColumnBuffer<float> TemperatureColumn;
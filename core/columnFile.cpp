@@ -0,0 +1,494 @@
+#include "./columnFile.h"
+#include "../utils/fileReader.h"
+#include "../utils/logger.h"
+#include "./temperatureSnapshot.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+static const char COLUMN_FILE_MAGIC[8] = {'W', 'X', 'C', 'O', 'L', 0, 0, 0};
+
+// Bit streams end with this much zero padding so the reader can always load
+// a whole 64-bit word.
+static const size_t BIT_STREAM_PADDING = 16;
+
+static const float DECIMAL_SCALES[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f};
+static const u_int MAX_DECIMALS = 4;
+
+// Fixed-point values stay below 2^24 so the float conversion is exact.
+static const int64_t MAX_FIXED_POINT = 1 << 24;
+
+enum TemperatureBlockMode { FIXED_POINT = 0, RAW = 1 };
+
+// mode, decimals, width, hasMissing, then the first value and the delta base.
+static const size_t TEMPERATURE_BLOCK_HEADER = 16;
+
+class BitWriter {
+public:
+  BitWriter(vector<char> &_out) : out(_out), buffer(0), used(0) {}
+
+  void write(uint64_t value, u_int bits) {
+    if (bits > 32) {
+      write(value & 0xffffffffULL, 32);
+      write(value >> 32, bits - 32);
+      return;
+    }
+
+    buffer |= value << used;
+    used += bits;
+
+    while (used >= 8) {
+      out.push_back(static_cast<char>(buffer & 0xff));
+      buffer >>= 8;
+      used -= 8;
+    }
+  }
+
+  void finish() {
+    if (used > 0) {
+      out.push_back(static_cast<char>(buffer & 0xff));
+    }
+
+    out.insert(out.end(), BIT_STREAM_PADDING, 0);
+  }
+
+private:
+  vector<char> &out;
+  uint64_t buffer;
+  u_int used;
+};
+
+class BitReader {
+public:
+  BitReader(const char *_data) : data(_data), position(0) {}
+
+  uint64_t read(u_int bits) {
+    if (bits > 32) {
+      const uint64_t low = read(32);
+      return low | (read(bits - 32) << 32);
+    }
+
+    uint64_t word;
+    memcpy(&word, data + (position >> 3), sizeof(word));
+    position += bits;
+
+    return (word >> ((position - bits) & 7)) & ((1ULL << bits) - 1);
+  }
+
+  size_t getPosition() const { return position; }
+
+private:
+  const char *data;
+  size_t position;
+};
+
+static uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static u_int bitWidth(uint64_t value) {
+  return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+static void appendBytes(vector<char> &out, const void *value, size_t size) {
+  const char *bytes = static_cast<const char *>(value);
+  out.insert(out.end(), bytes, bytes + size);
+}
+
+static bool sameBits(float left, float right) {
+  return memcmp(&left, &right, sizeof(float)) == 0;
+}
+
+// Fewest decimals that reproduce every present value exactly, or -1.
+static int findDecimals(const float *values, size_t count) {
+  for (u_int decimals = 0; decimals <= MAX_DECIMALS; ++decimals) {
+    const float scale = DECIMAL_SCALES[decimals];
+    bool exact = true;
+
+    for (size_t i = 0; i < count && exact; ++i) {
+      if (isnan(values[i])) {
+        continue;
+      }
+
+      const double scaled = static_cast<double>(values[i]) * scale;
+      if (!(fabs(scaled) < MAX_FIXED_POINT)) {
+        exact = false;
+        break;
+      }
+
+      const int64_t fixed = llround(scaled);
+      exact = sameBits(static_cast<float>(fixed) / scale, values[i]);
+    }
+
+    if (exact) {
+      return decimals;
+    }
+  }
+
+  return -1;
+}
+
+bool TemperatureColumnFile::isColumnFile(const string &path) {
+  const string extension = COLUMN_FILE_EXTENSION;
+
+  return path.size() >= extension.size() &&
+         path.compare(path.size() - extension.size(), extension.size(),
+                      extension) == 0;
+}
+
+void TemperatureColumnFile::encodeTimestamps(const int64_t *values,
+                                             size_t count, vector<char> &out) {
+  appendBytes(out, &values[0], sizeof(int64_t));
+
+  BitWriter writer{out};
+  int64_t delta = 0;
+
+  for (size_t i = 1; i < count; ++i) {
+    const int64_t current = values[i] - values[i - 1];
+    const uint64_t encoded = zigzag(current - delta);
+    delta = current;
+
+    if (encoded == 0) {
+      writer.write(0, 1);
+      continue;
+    }
+
+    const u_int width = bitWidth(encoded);
+    writer.write(1, 1);
+    writer.write(width - 1, 6);
+    writer.write(encoded, width);
+  }
+
+  writer.finish();
+}
+
+bool TemperatureColumnFile::decodeTimestamps(const char *begin,
+                                             const char *end, size_t count,
+                                             int64_t *values) {
+  if (static_cast<size_t>(end - begin) < sizeof(int64_t) + BIT_STREAM_PADDING) {
+    return false;
+  }
+
+  memcpy(&values[0], begin, sizeof(int64_t));
+
+  BitReader reader{begin + sizeof(int64_t)};
+  // Every read starts inside the data, the padding covers the word load.
+  const size_t limit =
+      (end - begin - sizeof(int64_t) - BIT_STREAM_PADDING) * 8;
+  int64_t delta = 0;
+
+  for (size_t i = 1; i < count; ++i) {
+    if (reader.getPosition() >= limit) {
+      return false;
+    }
+
+    if (reader.read(1) != 0) {
+      const u_int width = reader.read(6) + 1;
+      delta += unzigzag(reader.read(width));
+    }
+
+    values[i] = values[i - 1] + delta;
+  }
+
+  return reader.getPosition() <= limit;
+}
+
+void TemperatureColumnFile::encodeTemperatures(const float *values,
+                                               size_t count,
+                                               vector<char> &out) {
+  const int decimals = findDecimals(values, count);
+
+  unsigned char header[TEMPERATURE_BLOCK_HEADER] = {};
+
+  if (decimals < 0) {
+    header[0] = RAW;
+    appendBytes(out, header, sizeof(header));
+    appendBytes(out, values, count * sizeof(float));
+    return;
+  }
+
+  // Missing readings repeat the previous value so they cost no delta bits.
+  const float scale = DECIMAL_SCALES[decimals];
+  vector<int64_t> fixed(count);
+  bool hasMissing = false;
+
+  for (size_t i = 0; i < count; ++i) {
+    if (isnan(values[i])) {
+      fixed[i] = i == 0 ? 0 : fixed[i - 1];
+      hasMissing = true;
+    } else {
+      fixed[i] = llround(static_cast<double>(values[i]) * scale);
+    }
+  }
+
+  int64_t minDelta = 0;
+  int64_t maxDelta = 0;
+
+  for (size_t i = 1; i < count; ++i) {
+    const int64_t delta = fixed[i] - fixed[i - 1];
+    if (i == 1 || delta < minDelta) {
+      minDelta = delta;
+    }
+    if (i == 1 || delta > maxDelta) {
+      maxDelta = delta;
+    }
+  }
+
+  const int32_t first = static_cast<int32_t>(fixed[0]);
+  const u_int width = bitWidth(maxDelta - minDelta);
+
+  header[0] = FIXED_POINT;
+  header[1] = decimals;
+  header[2] = width;
+  header[3] = hasMissing;
+  memcpy(header + 4, &first, sizeof(first));
+  memcpy(header + 8, &minDelta, sizeof(minDelta));
+  appendBytes(out, header, sizeof(header));
+
+  if (hasMissing) {
+    vector<char> missing((count + 7) / 8, 0);
+    for (size_t i = 0; i < count; ++i) {
+      if (isnan(values[i])) {
+        missing[i / 8] |= 1 << (i % 8);
+      }
+    }
+    out.insert(out.end(), missing.begin(), missing.end());
+  }
+
+  BitWriter writer{out};
+  for (size_t i = 1; i < count; ++i) {
+    writer.write(fixed[i] - fixed[i - 1] - minDelta, width);
+  }
+  writer.finish();
+}
+
+bool TemperatureColumnFile::decodeTemperatures(const char *begin,
+                                               const char *end, size_t count,
+                                               float *values) {
+  const size_t size = end - begin;
+  if (size < TEMPERATURE_BLOCK_HEADER) {
+    return false;
+  }
+
+  const unsigned char mode = begin[0];
+
+  if (mode == RAW) {
+    if (size != TEMPERATURE_BLOCK_HEADER + count * sizeof(float)) {
+      return false;
+    }
+
+    memcpy(values, begin + TEMPERATURE_BLOCK_HEADER, count * sizeof(float));
+    return true;
+  }
+
+  const unsigned char decimals = begin[1];
+  const unsigned char width = begin[2];
+  const bool hasMissing = begin[3] != 0;
+  int32_t first;
+  int64_t minDelta;
+  memcpy(&first, begin + 4, sizeof(first));
+  memcpy(&minDelta, begin + 8, sizeof(minDelta));
+
+  const size_t missingSize = hasMissing ? (count + 7) / 8 : 0;
+  const size_t packedSize = ((count - 1) * width + 7) / 8;
+
+  if (mode != FIXED_POINT || decimals > MAX_DECIMALS || width > 32 ||
+      size != TEMPERATURE_BLOCK_HEADER + missingSize + packedSize +
+                  BIT_STREAM_PADDING) {
+    return false;
+  }
+
+  const char *missing = begin + TEMPERATURE_BLOCK_HEADER;
+  BitReader reader{missing + missingSize};
+  const float scale = DECIMAL_SCALES[decimals];
+
+  int64_t fixed = first;
+  values[0] = static_cast<float>(fixed) / scale;
+
+  for (size_t i = 1; i < count; ++i) {
+    fixed += minDelta + static_cast<int64_t>(reader.read(width));
+    values[i] = static_cast<float>(fixed) / scale;
+  }
+
+  if (hasMissing) {
+    for (size_t i = 0; i < count; ++i) {
+      if ((missing[i / 8] >> (i % 8)) & 1) {
+        values[i] = numeric_limits<float>::quiet_NaN();
+      }
+    }
+  }
+
+  return true;
+}
+
+bool TemperatureColumnFile::load(const string &path,
+                                 TemperatureStore &store) {
+  auto *logger = Logger::getInstance(EnvType::PROD);
+
+  MappedFile file{path};
+  if (!file.isOpen() || file.size() < sizeof(ColumnFileHeader)) {
+    logger->log("Could not read column file " + path);
+    return false;
+  }
+
+  ColumnFileHeader header;
+  memcpy(&header, file.data(), sizeof(header));
+
+  const uint64_t rows = header.rows;
+  const uint64_t blockRows = header.blockRows;
+
+  if (memcmp(header.magic, COLUMN_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != COLUMN_FILE_VERSION ||
+      header.locations != LOCATIONS_AMOUNT || blockRows == 0 ||
+      header.blocks != (rows + blockRows - 1) / blockRows) {
+    logger->log("Column file has an unknown format " + path);
+    return false;
+  }
+
+  const size_t columns = 1 + LOCATIONS_AMOUNT;
+  const size_t offsetCount = columns * header.blocks + 1;
+  const size_t tableSize = offsetCount * sizeof(uint64_t);
+
+  if (file.size() - sizeof(header) < tableSize) {
+    logger->log("Column file is truncated " + path);
+    return false;
+  }
+
+  const char *table = file.data() + sizeof(header);
+  const char *payload = table + tableSize;
+  const size_t payloadSize = file.size() - sizeof(header) - tableSize;
+
+  if (TemperatureSnapshot::hash(table, file.size() - sizeof(header)) !=
+      header.payloadHash) {
+    logger->log("Column file is corrupt " + path);
+    return false;
+  }
+
+  vector<uint64_t> offsets(offsetCount);
+  memcpy(offsets.data(), table, tableSize);
+
+  for (size_t i = 0; i + 1 < offsetCount; ++i) {
+    if (offsets[i] > offsets[i + 1]) {
+      logger->log("Column file is corrupt " + path);
+      return false;
+    }
+  }
+
+  if (offsets[0] != 0 || offsets.back() != payloadSize ||
+      rows > payloadSize * 8) {
+    logger->log("Column file is corrupt " + path);
+    return false;
+  }
+
+  vector<int64_t> timestamps(rows);
+  vector<vector<float>> temperatures(LOCATIONS_AMOUNT, vector<float>(rows));
+
+  for (size_t column = 0; column < columns; ++column) {
+    for (size_t block = 0; block < header.blocks; ++block) {
+      const size_t index = column * header.blocks + block;
+      const char *begin = payload + offsets[index];
+      const char *end = payload + offsets[index + 1];
+
+      const size_t firstRow = block * blockRows;
+      const size_t count = min<uint64_t>(blockRows, rows - firstRow);
+
+      const bool decoded =
+          column == 0
+              ? decodeTimestamps(begin, end, count, &timestamps[firstRow])
+              : decodeTemperatures(begin, end, count,
+                                   &temperatures[column - 1][firstRow]);
+
+      if (!decoded) {
+        logger->log("Column file is corrupt " + path);
+        return false;
+      }
+    }
+  }
+
+  TemperatureStore loaded{};
+  loaded.appendTimestamps(timestamps.data(), rows);
+
+  for (u_int i = 0; i < LOCATIONS_AMOUNT; ++i) {
+    loaded.setColumn(static_cast<EULocation>(i), move(temperatures[i]));
+  }
+
+  loaded.setSourceSize(file.size());
+  store = move(loaded);
+
+  return true;
+}
+
+bool TemperatureColumnFile::save(const string &path,
+                                 const TemperatureStore &store) {
+  auto *logger = Logger::getInstance(EnvType::PROD);
+
+  if (!store.isComplete()) {
+    logger->log("Only a fully loaded store can be written to " + path);
+    return false;
+  }
+
+  const size_t rows = store.size();
+  const size_t columns = 1 + LOCATIONS_AMOUNT;
+
+  ColumnFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, COLUMN_FILE_MAGIC, sizeof(header.magic));
+  header.version = COLUMN_FILE_VERSION;
+  header.locations = LOCATIONS_AMOUNT;
+  header.rows = rows;
+  header.blockRows = COLUMN_BLOCK_ROWS;
+  header.blocks = (rows + COLUMN_BLOCK_ROWS - 1) / COLUMN_BLOCK_ROWS;
+
+  vector<uint64_t> offsets{};
+  vector<char> payload{};
+
+  for (size_t column = 0; column < columns; ++column) {
+    for (size_t firstRow = 0; firstRow < rows;
+         firstRow += COLUMN_BLOCK_ROWS) {
+      const size_t count = min<size_t>(COLUMN_BLOCK_ROWS, rows - firstRow);
+      offsets.push_back(payload.size());
+
+      if (column == 0) {
+        encodeTimestamps(&store.getTimestamps()[firstRow], count, payload);
+      } else {
+        const TemperatureColumn &temperatures =
+            store.getColumn(static_cast<EULocation>(column - 1));
+        encodeTemperatures(&temperatures[firstRow], count, payload);
+      }
+    }
+  }
+  offsets.push_back(payload.size());
+
+  // The hash covers the offset table and the blocks as laid out on disk.
+  vector<char> body(offsets.size() * sizeof(uint64_t));
+  memcpy(body.data(), offsets.data(), body.size());
+  body.insert(body.end(), payload.begin(), payload.end());
+  header.payloadHash = TemperatureSnapshot::hash(body.data(), body.size());
+
+  const string temporaryPath = path + ".tmp";
+
+  FILE *file = fopen(temporaryPath.c_str(), "wb");
+  if (file == nullptr) {
+    logger->log("Could not write column file " + path);
+    return false;
+  }
+
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(body.data(), body.size(), 1, file) == 1;
+  written = fclose(file) == 0 && written;
+
+  if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    remove(temporaryPath.c_str());
+    logger->log("Could not write column file " + path);
+    return false;
+  }
+
+  return true;
+}
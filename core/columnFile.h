@@ -0,0 +1,52 @@
+#pragma once
+
+#include "./temperaturePoint.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define COLUMN_FILE_VERSION 1
+#define COLUMN_FILE_EXTENSION ".wcol"
+#define COLUMN_BLOCK_ROWS 4096
+
+// Compressed column archive of a TemperatureStore, an alternative to keeping
+// the raw CSV. Layout: ColumnFileHeader, an offset table with one entry per
+// (column, block) plus the end offset, then the blocks. Column 0 holds the
+// timestamps and column 1 + l the temperatures of EULocation l. Every block
+// covers COLUMN_BLOCK_ROWS rows and decodes on its own.
+//
+// Timestamps: the block's first value, then a bit stream of delta-of-deltas
+// where an unchanged step (the usual +3600s) costs a single 0 bit.
+// Temperatures: fixed-point with the fewest decimals (up to 4) that give
+// back every float of the block bit for bit, stored as the first value and
+// bit-packed deltas from the smallest delta. Missing readings are kept in a
+// bitmap; blocks that do not fit fixed-point keep raw floats.
+struct ColumnFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t locations;
+  uint64_t rows;
+  uint32_t blockRows;
+  uint32_t blocks;
+  uint64_t payloadHash;
+};
+
+class TemperatureColumnFile {
+public:
+  static bool isColumnFile(const string &path);
+
+  static bool load(const string &path, TemperatureStore &store);
+  static bool save(const string &path, const TemperatureStore &store);
+
+private:
+  static void encodeTimestamps(const int64_t *values, size_t count,
+                               vector<char> &out);
+  static bool decodeTimestamps(const char *begin, const char *end,
+                               size_t count, int64_t *values);
+  static void encodeTemperatures(const float *values, size_t count,
+                                 vector<char> &out);
+  static bool decodeTemperatures(const char *begin, const char *end,
+                                 size_t count, float *values);
+};
@@ -0,0 +1,113 @@
+#include "./decimation.h"
+#include "./candlestick.h"
+#include <algorithm>
+#include <cmath>
+
+void Decimation::minMax(const vector<Candlestick> &candlesticks,
+                        size_t columns, vector<Candlestick> &decimated) {
+  decimated.clear();
+  if (columns == 0) {
+    return;
+  }
+  decimated.reserve(columns);
+
+  const size_t size = candlesticks.size();
+  for (size_t column = 0; column < columns; ++column) {
+    const size_t begin = column * size / columns;
+    const size_t end = (column + 1) * size / columns;
+    if (begin == end) {
+      continue;
+    }
+
+    Candlestick merged = candlesticks[begin];
+    for (size_t i = begin + 1; i < end; ++i) {
+      merged.high = max(merged.high, candlesticks[i].high);
+      merged.low = min(merged.low, candlesticks[i].low);
+    }
+    merged.close = candlesticks[end - 1].close;
+
+    decimated.push_back(merged);
+  }
+}
+
+void Decimation::largestTriangle(const vector<Candlestick> &candlesticks,
+                                 size_t columns,
+                                 vector<Candlestick> &decimated) {
+  const size_t size = candlesticks.size();
+  if (columns < 3) {
+    minMax(candlesticks, columns, decimated);
+    return;
+  }
+
+  decimated.clear();
+  decimated.reserve(columns);
+  decimated.push_back(candlesticks.front());
+
+  // The runs between the first and the last candlestick, as fractions of
+  // the series, with x the index and y the close.
+  const double every = double(size - 2) / (columns - 2);
+  size_t previous = 0;
+
+  for (size_t run = 0; run < columns - 2; ++run) {
+    const size_t begin = size_t(run * every) + 1;
+    const size_t end = size_t((run + 1) * every) + 1;
+    const size_t nextEnd = min(size_t((run + 2) * every) + 1, size);
+
+    double averageX = 0;
+    double averageY = 0;
+    for (size_t i = end; i < nextEnd; ++i) {
+      averageX += i;
+      averageY += candlesticks[i].close;
+    }
+    if (nextEnd > end) {
+      averageX /= nextEnd - end;
+      averageY /= nextEnd - end;
+    } else {
+      averageX = size - 1;
+      averageY = candlesticks.back().close;
+    }
+
+    const double previousX = previous;
+    const double previousY = candlesticks[previous].close;
+    double largestArea = -1;
+    size_t picked = begin;
+
+    for (size_t i = begin; i < end; ++i) {
+      const double area =
+          fabs((previousX - averageX) * (candlesticks[i].close - previousY) -
+               (previousX - i) * (averageY - previousY));
+      if (area > largestArea) {
+        largestArea = area;
+        picked = i;
+      }
+    }
+
+    decimated.push_back(candlesticks[picked]);
+    previous = picked;
+  }
+
+  decimated.push_back(candlesticks.back());
+}
+
+void Decimation::decimate(const vector<Candlestick> &candlesticks,
+                          size_t columns, DecimationMode mode,
+                          vector<Candlestick> &decimated) {
+  if (candlesticks.size() <= columns || mode == DecimationMode::PAGED) {
+    decimated.assign(candlesticks.begin(), candlesticks.end());
+  } else if (mode == DecimationMode::LTTB) {
+    largestTriangle(candlesticks, columns, decimated);
+  } else {
+    minMax(candlesticks, columns, decimated);
+  }
+}
+
+string Decimation::modeToString(DecimationMode mode) {
+  switch (mode) {
+  case DecimationMode::MIN_MAX:
+    return "min/max overview";
+  case DecimationMode::LTTB:
+    return "LTTB overview";
+  default:
+    return "paged";
+  }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// candlestick.h reaches the menu headers, which include this one.
+class Candlestick;
+
+// How the graph fits the candlesticks on screen: PAGED shows the first ones
+// one slot apart, the others reduce the whole series to one candlestick per
+// terminal column.
+enum class DecimationMode { PAGED, MIN_MAX, LTTB };
+
+// Reduces a series to a given number of candlesticks in one pass over it.
+// The result replaces the contents of decimated, whose capacity is reused,
+// so redrawing an overview of the same width allocates nothing.
+class Decimation {
+public:
+  // Columns equal runs of candlesticks, each merged into one: first open,
+  // last close and the extremes of high and low, so no spike is lost.
+  static void minMax(const vector<Candlestick> &candlesticks, size_t columns,
+                     vector<Candlestick> &decimated);
+  // Largest triangle three buckets over the closes. Keeps the first and the
+  // last candlestick and, from each run in between, the one making the
+  // largest triangle with the previous pick and the next run's average.
+  static void largestTriangle(const vector<Candlestick> &candlesticks,
+                              size_t columns, vector<Candlestick> &decimated);
+
+  // Series no longer than columns are copied as they are.
+  static void decimate(const vector<Candlestick> &candlesticks, size_t columns,
+                       DecimationMode mode, vector<Candlestick> &decimated);
+
+  static string modeToString(DecimationMode mode);
+};
@@ -0,0 +1,99 @@
+#include "./rangeQueryTable.h"
+#include <algorithm>
+
+static size_t floorLog2(size_t value) {
+  return 63 - __builtin_clzll(value);
+}
+
+RangeQueryTable::RangeQueryTable()
+    : prefixSums(1, 0), prefixCounts(1, 0), processedRows(0) {}
+
+void RangeQueryTable::update(const TemperatureColumn &temperatures) {
+  // Only whole blocks are tabulated, the rows after the last one are
+  // scanned by query.
+  const size_t blocksAmount = temperatures.size() / RANGE_BLOCK_ROWS;
+
+  for (size_t block = blocks.size(); block < blocksAmount; ++block) {
+    blocks.push_back(SimdReduction::summarize(
+        temperatures.data() + block * RANGE_BLOCK_ROWS, RANGE_BLOCK_ROWS));
+    prefixSums.push_back(prefixSums.back() + blocks.back().sum);
+    prefixCounts.push_back(prefixCounts.back() + blocks.back().count);
+  }
+
+  for (size_t level = 0; (size_t(1) << level) <= blocks.size(); ++level) {
+    if (level == lowest.size()) {
+      lowest.emplace_back();
+      highest.emplace_back();
+    }
+
+    const size_t span = size_t(1) << level;
+    const size_t half = span / 2;
+    vector<float> &levelLowest = lowest[level];
+    vector<float> &levelHighest = highest[level];
+
+    for (size_t i = levelLowest.size(); i + span <= blocks.size(); ++i) {
+      if (level == 0) {
+        levelLowest.push_back(blocks[i].lowest);
+        levelHighest.push_back(blocks[i].highest);
+        continue;
+      }
+
+      levelLowest.push_back(
+          min(lowest[level - 1][i], lowest[level - 1][i + half]));
+      levelHighest.push_back(
+          max(highest[level - 1][i], highest[level - 1][i + half]));
+    }
+  }
+
+  processedRows = max(processedRows, temperatures.size());
+}
+
+FloatSummary RangeQueryTable::query(const TemperatureColumn &temperatures,
+                                    size_t begin, size_t end) const {
+  end = min(end, min(processedRows, temperatures.size()));
+  if (begin >= end) {
+    return FloatSummary{};
+  }
+
+  const size_t firstBlock = (begin + RANGE_BLOCK_ROWS - 1) / RANGE_BLOCK_ROWS;
+  const size_t lastBlock = min(blocks.size(), end / RANGE_BLOCK_ROWS);
+
+  if (firstBlock >= lastBlock) {
+    return SimdReduction::summarize(temperatures.data() + begin, end - begin);
+  }
+
+  FloatSummary result = SimdReduction::summarize(
+      temperatures.data() + begin, firstBlock * RANGE_BLOCK_ROWS - begin);
+  result.merge(queryBlocks(firstBlock, lastBlock));
+  result.merge(
+      SimdReduction::summarize(temperatures.data() + lastBlock *
+                                                         RANGE_BLOCK_ROWS,
+                               end - lastBlock * RANGE_BLOCK_ROWS));
+
+  return result;
+}
+
+FloatSummary RangeQueryTable::queryBlocks(size_t begin, size_t end) const {
+  FloatSummary result{};
+  result.count = prefixCounts[end] - prefixCounts[begin];
+  if (result.count == 0) {
+    return FloatSummary{};
+  }
+
+  result.sum = prefixSums[end] - prefixSums[begin];
+
+  // Two overlapping power-of-two runs cover [begin, end) exactly.
+  const size_t level = floorLog2(end - begin);
+  const size_t second = end - (size_t(1) << level);
+  result.lowest = min(lowest[level][begin], lowest[level][second]);
+  result.highest = max(highest[level][begin], highest[level][second]);
+
+  // The first block with a present reading is where the count first rises.
+  const size_t block =
+      upper_bound(prefixCounts.begin() + begin + 1,
+                  prefixCounts.begin() + end + 1, prefixCounts[begin]) -
+      prefixCounts.begin() - 1;
+  result.first = blocks[block].first;
+
+  return result;
+}
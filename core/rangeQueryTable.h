@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../utils/simdReduction.h"
+#include "./columnBuffer.h"
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Rows per block, the partial blocks at the ends of a window are scanned.
+#define RANGE_BLOCK_ROWS 64
+
+// Constant time min / max / sum / count over any row window of one
+// temperature column. Rows are grouped in blocks: a sparse table over the
+// blocks gives the lowest and highest of a run of whole blocks with two
+// lookups, prefix sums give its sum and count, and the two partial blocks at
+// the ends of the window go through SimdReduction. Appending rows only ever
+// appends to the tables.
+class RangeQueryTable {
+public:
+  RangeQueryTable();
+
+  // Folds in the rows appended since the previous call.
+  void update(const TemperatureColumn &temperatures);
+
+  // Present readings of rows [begin, end), clamped to the rows folded in.
+  FloatSummary query(const TemperatureColumn &temperatures, size_t begin,
+                     size_t end) const;
+
+  size_t getProcessedRows() const { return processedRows; }
+
+private:
+  vector<FloatSummary> blocks;
+  // Totals of the blocks before each index, one entry more than blocks.
+  vector<double> prefixSums;
+  vector<size_t> prefixCounts;
+  // lowest[k][i] and highest[k][i] cover blocks [i, i + 2^k).
+  vector<vector<float>> lowest;
+  vector<vector<float>> highest;
+  size_t processedRows;
+
+  FloatSummary queryBlocks(size_t begin, size_t end) const;
+};
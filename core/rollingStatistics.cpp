@@ -0,0 +1,133 @@
+#include "./rollingStatistics.h"
+#include <algorithm>
+#include <cmath>
+
+FenwickTree::FenwickTree(size_t size) : counts(size + 1, 0), highestBit(1) {
+  while (highestBit * 2 <= size) {
+    highestBit *= 2;
+  }
+}
+
+void FenwickTree::add(size_t rank, int delta) {
+  for (size_t i = rank + 1; i < counts.size(); i += i & (~i + 1)) {
+    counts[i] += delta;
+  }
+}
+
+// Descends from the highest power of two, keeping every step whose prefix
+// still falls short of k.
+size_t FenwickTree::findKth(size_t k) const {
+  size_t position = 0;
+  int remaining = static_cast<int>(k);
+
+  for (size_t step = highestBit; step > 0; step /= 2) {
+    const size_t next = position + step;
+    if (next < counts.size() && counts[next] < remaining) {
+      position = next;
+      remaining -= counts[next];
+    }
+  }
+
+  return position;
+}
+
+RollingStatistics::RollingStatistics(const vector<float> &_values,
+                                     size_t _window, float _quantile)
+    : values(_values), window(max<size_t>(1, _window)),
+      quantile(min(1.0f, max(0.0f, _quantile))), begin(0), end(0),
+      offset(_values.empty() ? 0 : _values.front()), sum(0), squares(0),
+      ranks(_values.size()), tree(_values.size()) {
+  vector<size_t> order(values.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+
+  // Equal values get distinct ranks, so every rank maps back to one value.
+  sort(order.begin(), order.end(),
+       [this](size_t a, size_t b) { return values[a] < values[b]; });
+
+  sorted.reserve(values.size());
+  for (size_t rank = 0; rank < order.size(); ++rank) {
+    ranks[order[rank]] = rank;
+    sorted.push_back(values[order[rank]]);
+  }
+}
+
+bool RollingStatistics::advance() {
+  if (end == values.size()) {
+    return false;
+  }
+
+  const size_t row = end++;
+  const double value = values[row] - offset;
+
+  sum += value;
+  squares += value * value;
+  tree.add(ranks[row], 1);
+
+  while (!lowestRows.empty() && values[lowestRows.back()] >= values[row]) {
+    lowestRows.pop_back();
+  }
+  lowestRows.push_back(row);
+
+  while (!highestRows.empty() && values[highestRows.back()] <= values[row]) {
+    highestRows.pop_back();
+  }
+  highestRows.push_back(row);
+
+  if (end - begin > window) {
+    remove(begin++);
+  }
+
+  return true;
+}
+
+void RollingStatistics::remove(size_t row) {
+  const double value = values[row] - offset;
+
+  sum -= value;
+  squares -= value * value;
+  tree.add(ranks[row], -1);
+
+  if (lowestRows.front() == row) {
+    lowestRows.pop_front();
+  }
+
+  if (highestRows.front() == row) {
+    highestRows.pop_front();
+  }
+}
+
+RollingSnapshot RollingStatistics::getSnapshot() const {
+  RollingSnapshot snapshot{};
+  snapshot.count = end - begin;
+  if (snapshot.count == 0) {
+    return snapshot;
+  }
+
+  const double mean = sum / snapshot.count;
+  snapshot.mean = static_cast<float>(mean + offset);
+  const double variance = squares / snapshot.count - mean * mean;
+  snapshot.deviation = static_cast<float>(sqrt(max(0.0, variance)));
+  snapshot.lowest = values[lowestRows.front()];
+  snapshot.highest = values[highestRows.front()];
+
+  const size_t k = 1 + static_cast<size_t>(quantile * (snapshot.count - 1));
+  snapshot.percentile = sorted[tree.findKth(k)];
+
+  return snapshot;
+}
+
+vector<RollingSnapshot> RollingStatistics::compute(const vector<float> &values,
+                                                   size_t window,
+                                                   float quantile) {
+  vector<RollingSnapshot> snapshots;
+  snapshots.reserve(values.size());
+
+  RollingStatistics statistics{values, window, quantile};
+  while (statistics.advance()) {
+    snapshots.push_back(statistics.getSnapshot());
+  }
+
+  return snapshots;
+}
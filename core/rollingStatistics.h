@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+// Statistics of the values inside one window position.
+class RollingSnapshot {
+public:
+  float mean;
+  float deviation;
+  float lowest;
+  float highest;
+  float percentile;
+  size_t count;
+};
+
+// Occurrences per rank with prefix sums over them, so the k-th smallest
+// rank in the tree is found in logarithmic time.
+class FenwickTree {
+public:
+  FenwickTree(size_t size);
+
+  void add(size_t rank, int delta);
+  // Smallest rank with k occurrences at or below it, k counts from 1.
+  size_t findKth(size_t k) const;
+
+private:
+  vector<int> counts;
+  size_t highestBit;
+};
+
+// Sliding window over a series. Mean and deviation come from running sums,
+// lowest and highest from monotonic deques of rows whose fronts are the
+// window extremes, so those are O(1) amortised per step. The percentile is
+// read from a Fenwick tree over the ranks of the values, O(log n) per step.
+class RollingStatistics {
+public:
+  // Values are ranked up front for the percentile tree, quantile is in
+  // [0, 1] and 0.5 gives the median.
+  RollingStatistics(const vector<float> &_values, size_t _window,
+                    float _quantile = 0.5f);
+
+  // Moves the window end over the next value, dropping the one that falls
+  // out. False once every value has been taken in.
+  bool advance();
+  RollingSnapshot getSnapshot() const;
+
+  // One snapshot per value, each over the window ending at that value. The
+  // first window - 1 snapshots cover the values seen so far.
+  static vector<RollingSnapshot> compute(const vector<float> &values,
+                                         size_t window,
+                                         float quantile = 0.5f);
+
+private:
+  const vector<float> &values;
+  size_t window;
+  float quantile;
+
+  size_t begin;
+  size_t end;
+  // Sums are taken relative to the first value, which keeps the variance
+  // from cancelling out on large readings.
+  double offset;
+  double sum;
+  double squares;
+  deque<size_t> lowestRows;
+  deque<size_t> highestRows;
+
+  vector<size_t> ranks;
+  vector<float> sorted;
+  FenwickTree tree;
+
+  void remove(size_t row);
+};
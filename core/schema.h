@@ -0,0 +1,407 @@
+#pragma once
+
+#include "../utils/fieldParser.h"
+#include "../utils/fileReader.h"
+#include "./columnBuffer.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+// Compile-time CSV schemas. A schema lists its column declarations in file
+// order and RowParser<S> / ColumnStore<S> are generated from it, so every
+// field is handled by a statically chosen routine with no per-field type
+// dispatch at run time.
+//
+//   Column<Type, Name>   one field, parsed as Type and stored in its column
+//   Skip<Name>           one field that is never materialised
+//   Repeat<N, Decls...>  the group Decls... repeated N times
+//
+// Name is a policy with `static string name(size_t repeatIndex)`, used to
+// check a file's header against the schema.
+
+struct TimestampType {
+  typedef int64_t value_type;
+  // Rows whose required fields do not parse are dropped.
+  static const bool required = true;
+
+  static bool parse(const StringSpan &field, const char *, int64_t &value) {
+    return FieldParser::parseTimestamp(field.data, field.end(), value);
+  }
+  static int64_t missing() { return 0; }
+};
+
+struct FloatType {
+  typedef float value_type;
+  static const bool required = false;
+
+  static bool parse(const StringSpan &field, const char *limit, float &value) {
+    return FieldParser::parseFloat(field.data, field.end(), limit, value);
+  }
+  static float missing() { return numeric_limits<float>::quiet_NaN(); }
+};
+
+template <typename Type, typename Name> struct Column {};
+template <typename Name> struct Skip {};
+template <size_t Count, typename... Declarations> struct Repeat {};
+template <typename... Declarations> struct Schema {};
+
+struct EmptyColumn {};
+
+template <typename Declaration> struct DeclarationOps;
+
+// Walks a group of declarations; Index is the position in the group's
+// tuples, offset the CSV field index of the group's first field.
+template <size_t Index, typename... Declarations> struct GroupOps {
+  static const size_t width = 0;
+
+  template <typename Values>
+  static bool parse(const StringSpan *, const char *, const vector<bool> &,
+                    size_t, Values &) {
+    return true;
+  }
+  template <typename Storage, typename Values>
+  static void append(Storage &, const Values &, const vector<bool> &,
+                     size_t) {}
+  template <typename Storage>
+  static void appendAll(Storage &, const Storage &, const vector<bool> &,
+                        size_t) {}
+  template <typename Storage>
+  static void reserve(Storage &, size_t, const vector<bool> &, size_t) {}
+  static void describe(vector<string> &, vector<bool> &, vector<bool> &,
+                       size_t) {}
+};
+
+template <size_t Index, typename Declaration, typename... Rest>
+struct GroupOps<Index, Declaration, Rest...> {
+  typedef DeclarationOps<Declaration> Head;
+  typedef GroupOps<Index + 1, Rest...> Tail;
+
+  static const size_t width = Head::width + Tail::width;
+
+  template <typename Values>
+  static bool parse(const StringSpan *fields, const char *limit,
+                    const vector<bool> &mask, size_t offset, Values &values) {
+    return Head::parse(fields, limit, mask, offset, get<Index>(values)) &&
+           Tail::parse(fields, limit, mask, offset + Head::width, values);
+  }
+
+  template <typename Storage, typename Values>
+  static void append(Storage &storage, const Values &values,
+                     const vector<bool> &mask, size_t offset) {
+    Head::append(get<Index>(storage), get<Index>(values), mask, offset);
+    Tail::append(storage, values, mask, offset + Head::width);
+  }
+
+  template <typename Storage>
+  static void appendAll(Storage &storage, const Storage &other,
+                        const vector<bool> &mask, size_t offset) {
+    Head::appendAll(get<Index>(storage), get<Index>(other), mask, offset);
+    Tail::appendAll(storage, other, mask, offset + Head::width);
+  }
+
+  template <typename Storage>
+  static void reserve(Storage &storage, size_t rows, const vector<bool> &mask,
+                      size_t offset) {
+    Head::reserve(get<Index>(storage), rows, mask, offset);
+    Tail::reserve(storage, rows, mask, offset + Head::width);
+  }
+
+  static void describe(vector<string> &names, vector<bool> &stored,
+                       vector<bool> &required, size_t repeatIndex) {
+    Head::describe(names, stored, required, repeatIndex);
+    Tail::describe(names, stored, required, repeatIndex);
+  }
+};
+
+template <typename Type, typename Name>
+struct DeclarationOps<Column<Type, Name>> {
+  static const size_t width = 1;
+  typedef typename Type::value_type value_type;
+  typedef ColumnBuffer<value_type> storage_type;
+
+  static bool parse(const StringSpan *fields, const char *limit,
+                    const vector<bool> &mask, size_t offset,
+                    value_type &value) {
+    if (mask[offset] && Type::parse(fields[offset], limit, value)) {
+      return true;
+    }
+
+    value = Type::missing();
+    return !Type::required;
+  }
+
+  static void append(storage_type &storage, const value_type &value,
+                     const vector<bool> &mask, size_t offset) {
+    if (mask[offset]) {
+      storage.push_back(value);
+    }
+  }
+
+  static void appendAll(storage_type &storage, const storage_type &other,
+                        const vector<bool> &mask, size_t offset) {
+    if (mask[offset]) {
+      storage.append(other.begin(), other.end());
+    }
+  }
+
+  static void reserve(storage_type &storage, size_t rows,
+                      const vector<bool> &mask, size_t offset) {
+    if (mask[offset]) {
+      storage.reserve(rows);
+    }
+  }
+
+  static void describe(vector<string> &names, vector<bool> &stored,
+                       vector<bool> &required, size_t repeatIndex) {
+    names.push_back(Name::name(repeatIndex));
+    stored.push_back(true);
+    required.push_back(Type::required);
+  }
+};
+
+template <typename Name> struct DeclarationOps<Skip<Name>> {
+  static const size_t width = 1;
+  typedef EmptyColumn value_type;
+  typedef EmptyColumn storage_type;
+
+  static bool parse(const StringSpan *, const char *, const vector<bool> &,
+                    size_t, value_type &) {
+    return true;
+  }
+  static void append(storage_type &, const value_type &,
+                     const vector<bool> &, size_t) {}
+  static void appendAll(storage_type &, const storage_type &,
+                        const vector<bool> &, size_t) {}
+  static void reserve(storage_type &, size_t, const vector<bool> &, size_t) {}
+
+  static void describe(vector<string> &names, vector<bool> &stored,
+                       vector<bool> &required, size_t repeatIndex) {
+    names.push_back(Name::name(repeatIndex));
+    stored.push_back(false);
+    required.push_back(false);
+  }
+};
+
+template <size_t Count, typename... Declarations>
+struct DeclarationOps<Repeat<Count, Declarations...>> {
+  typedef GroupOps<0, Declarations...> Group;
+
+  static const size_t width = Count * Group::width;
+  typedef array<tuple<typename DeclarationOps<Declarations>::value_type...>,
+                Count>
+      value_type;
+  typedef array<tuple<typename DeclarationOps<Declarations>::storage_type...>,
+                Count>
+      storage_type;
+
+  static bool parse(const StringSpan *fields, const char *limit,
+                    const vector<bool> &mask, size_t offset,
+                    value_type &values) {
+    for (size_t i = 0; i < Count; ++i) {
+      if (!Group::parse(fields, limit, mask, offset + i * Group::width,
+                        values[i])) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  static void append(storage_type &storage, const value_type &values,
+                     const vector<bool> &mask, size_t offset) {
+    for (size_t i = 0; i < Count; ++i) {
+      Group::append(storage[i], values[i], mask, offset + i * Group::width);
+    }
+  }
+
+  static void appendAll(storage_type &storage, const storage_type &other,
+                        const vector<bool> &mask, size_t offset) {
+    for (size_t i = 0; i < Count; ++i) {
+      Group::appendAll(storage[i], other[i], mask, offset + i * Group::width);
+    }
+  }
+
+  static void reserve(storage_type &storage, size_t rows,
+                      const vector<bool> &mask, size_t offset) {
+    for (size_t i = 0; i < Count; ++i) {
+      Group::reserve(storage[i], rows, mask, offset + i * Group::width);
+    }
+  }
+
+  static void describe(vector<string> &names, vector<bool> &stored,
+                       vector<bool> &required, size_t) {
+    for (size_t i = 0; i < Count; ++i) {
+      Group::describe(names, stored, required, i);
+    }
+  }
+};
+
+template <typename... Declarations>
+struct DeclarationOps<Schema<Declarations...>> {
+  typedef GroupOps<0, Declarations...> Group;
+
+  static const size_t width = Group::width;
+  typedef tuple<typename DeclarationOps<Declarations>::value_type...>
+      value_type;
+  typedef tuple<typename DeclarationOps<Declarations>::storage_type...>
+      storage_type;
+};
+
+// Which of a schema's fields to materialise. Built once per load by
+// RowParser::makeMask, then shared by every row.
+class FieldMask {
+public:
+  vector<bool> fields;
+  // Fields after this one are never looked at.
+  size_t lastField;
+  // Rows with fewer fields cannot fill every stored column and are dropped;
+  // this does not depend on the projection, so projected and full loads
+  // always keep the same rows.
+  size_t minFields;
+};
+
+template <typename S> class RowParser {
+public:
+  typedef DeclarationOps<S> Ops;
+  typedef typename Ops::value_type row_type;
+  static const size_t width = Ops::width;
+
+  static vector<string> names() {
+    vector<string> names{};
+    vector<bool> stored{};
+    vector<bool> required{};
+    Ops::Group::describe(names, stored, required, 0);
+    return names;
+  }
+
+  // projection selects fields by index, empty selects every stored field.
+  // Required fields are always parsed.
+  static FieldMask makeMask(const vector<bool> &projection = vector<bool>()) {
+    vector<string> names{};
+    vector<bool> stored{};
+    vector<bool> required{};
+    Ops::Group::describe(names, stored, required, 0);
+
+    FieldMask mask;
+    mask.fields = vector<bool>(width, false);
+    mask.lastField = 0;
+    mask.minFields = 0;
+
+    for (size_t i = 0; i < width; ++i) {
+      const bool selected = projection.empty() || projection[i];
+      mask.fields[i] = stored[i] && (selected || required[i]);
+
+      if (mask.fields[i]) {
+        mask.lastField = i;
+      }
+      if (stored[i]) {
+        mask.minFields = i + 1;
+      }
+    }
+
+    return mask;
+  }
+
+  static bool parse(const StringSpan &row, const FieldMask &mask,
+                    row_type &values) {
+    StringSpan fields[width];
+    const char *field = row.data;
+    size_t found = 0;
+
+    for (; found <= mask.lastField; ++found) {
+      if (field > row.end()) {
+        return false;
+      }
+
+      const char *fieldEnd =
+          static_cast<const char *>(memchr(field, ',', row.end() - field));
+      if (fieldEnd == nullptr) {
+        fieldEnd = row.end();
+      }
+
+      fields[found] = StringSpan(field, fieldEnd - field);
+      field = fieldEnd + 1;
+    }
+
+    // The rest of the row is only scanned until enough fields are seen,
+    // never split.
+    for (; found < mask.minFields; ++found) {
+      if (field > row.end()) {
+        return false;
+      }
+
+      const char *fieldEnd =
+          static_cast<const char *>(memchr(field, ',', row.end() - field));
+      field = fieldEnd != nullptr ? fieldEnd + 1 : row.end() + 1;
+    }
+
+    return Ops::Group::parse(fields, row.end(), mask.fields, 0, values);
+  }
+
+  // True when the header names every column the way the schema does.
+  static bool checkHeader(const StringSpan &header) {
+    vector<StringSpan> tokens{};
+    FileReader::tokenise(header, ',', tokens);
+
+    const vector<string> expected = names();
+    if (tokens.size() < expected.size()) {
+      return false;
+    }
+
+    for (size_t i = 0; i < expected.size(); ++i) {
+      if (tokens[i].toString() != expected[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+};
+
+template <typename S> class ColumnStore {
+public:
+  typedef DeclarationOps<S> Ops;
+  typedef typename Ops::storage_type storage_type;
+  typedef typename Ops::value_type row_type;
+
+  ColumnStore() : rows(0) {}
+
+  size_t size() const { return rows; }
+
+  template <size_t I> typename tuple_element<I, storage_type>::type &column() {
+    return get<I>(storage);
+  }
+  template <size_t I>
+  const typename tuple_element<I, storage_type>::type &column() const {
+    return get<I>(storage);
+  }
+
+  void append(const row_type &values, const FieldMask &mask) {
+    Ops::Group::append(storage, values, mask.fields, 0);
+    ++rows;
+  }
+
+  void append(const ColumnStore &other, const FieldMask &mask) {
+    Ops::Group::appendAll(storage, other.storage, mask.fields, 0);
+    rows += other.rows;
+  }
+
+  void reserve(size_t count, const FieldMask &mask) {
+    Ops::Group::reserve(storage, count, mask.fields, 0);
+  }
+
+  // For columns filled outside append(), e.g. bulk loads.
+  void setSize(size_t _rows) { rows = _rows; }
+
+private:
+  storage_type storage;
+  size_t rows;
+};
@@ -1,9 +1,19 @@
 #include "./temperaturePoint.h"
+#include "../utils/dateTime.h"
 #include "../utils/fileReader.h"
 #include "../utils/logger.h"
+#include "./columnFile.h"
+#include "./temperatureSnapshot.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <thread>
 #include <utility>
 
 const std::unordered_map<string, EULocation> stringToLocationsMap = {
@@ -46,34 +56,387 @@ TemperaturePoint::TemperaturePoint(EULocation _location, float _temperature,
                                    string _date)
     : location(_location), temperature(_temperature), date(_date) {}
 
-vector<TemperaturePoint>
-TemparatureDataExtractor::getTemperatures(const string &path) {
-  vector<TemperaturePoint> points{};
+static u_int resolveThreads(u_int threads) {
+  if (threads == 0) {
+    return max(1u, thread::hardware_concurrency());
+  }
+
+  return threads;
+}
+
+static vector<bool> projectionFor(const vector<EULocation> &locations) {
+  if (locations.empty()) {
+    return vector<bool>(LOCATIONS_AMOUNT, true);
+  }
+
+  vector<bool> projection(LOCATIONS_AMOUNT, false);
+  for (EULocation location : locations) {
+    if (location < LOCATIONS_AMOUNT) {
+      projection[location] = true;
+    }
+  }
+
+  return projection;
+}
+
+TemperatureStore
+TemparatureDataExtractor::getTemperatures(const string &path,
+                                          const LoadOptions &options) {
+  TemperatureStore store{};
+
+  // Column files are already parsed, there is nothing to cache.
+  if (TemperatureColumnFile::isColumnFile(path)) {
+    // Like an unreadable CSV, a bad column file leaves the store empty.
+    if (!TemperatureColumnFile::load(path, store)) {
+      Logger::getInstance(EnvType::PROD)
+          ->log("Could not load column file " + path + ", no rows read");
+      store = TemperatureStore{};
+    }
+
+    store.setSource(path, options);
+    return store;
+  }
+
+  if (options.snapshot &&
+      TemperatureSnapshot::load(path, store, options.verifySnapshot)) {
+    store.setSource(path, options);
+    return store;
+  }
+
+  store = parseCsv(path, options);
+  store.setSource(path, options);
+
+  // A projected store is missing columns, so it cannot seed the snapshot.
+  if (options.snapshot && store.isComplete()) {
+    TemperatureSnapshot::save(path, store);
+  }
+
+  return store;
+}
+
+void TemparatureDataExtractor::loadLocation(TemperatureStore &store,
+                                            EULocation location) {
+  if (location >= LOCATIONS_AMOUNT || store.isLoaded(location)) {
+    return;
+  }
+
+  auto *logger = Logger::getInstance(EnvType::PROD);
+  logger->log("Loading location column " +
+              LocationEnumProcessor::locationToString(location));
+
+  const LoadOptions &options = store.getSourceOptions();
+  TemperatureStore projected =
+      readMapped(store.getSourcePath(), resolveThreads(options.threads),
+                 projectionFor(vector<EULocation>{location}),
+                 store.getSourceSize());
+
+  if (projected.getTimestamps() != store.getTimestamps()) {
+    throw runtime_error("Dataset changed since it was loaded");
+  }
+
+  TemperatureColumn column = projected.getColumn(location);
+  store.setColumn(location, move(column));
+}
+
+size_t TemparatureDataExtractor::appendNewRows(TemperatureStore &store) {
+  auto *logger = Logger::getInstance(EnvType::PROD);
+
+  // Only a CSV source can grow row by row.
+  if (TemperatureColumnFile::isColumnFile(store.getSourcePath())) {
+    return 0;
+  }
+
+  MappedFile file{store.getSourcePath()};
+  if (!file.isOpen()) {
+    return 0;
+  }
+
+  if (file.size() < store.getSourceSize()) {
+    logger->log("Dataset was truncated, ignoring it until it grows back");
+    return 0;
+  }
+
+  const char *begin = file.data() + store.getSourceSize();
+  const char *end = file.data() + file.size();
+
+  // Only complete lines; a row still being written is picked up next time.
+  const char *lastNewline = begin;
+  for (const char *cursor = end; cursor > begin; --cursor) {
+    if (cursor[-1] == '\n') {
+      lastNewline = cursor;
+      break;
+    }
+  }
+
+  if (lastNewline == begin) {
+    return 0;
+  }
+
+  TemperatureStore appended{};
+  appended.setLoadedColumns(store.getLoadedColumns());
+  parseRows(begin, lastNewline, appended);
+
+  if (!appended.getTimestamps().empty() && store.size() > 0 &&
+      appended.getTimestamps().front() < store.getTimestamps().back()) {
+    logger->log("Appended rows are older than the dataset, skipping them");
+    store.setSourceSize(lastNewline - file.data());
+    return 0;
+  }
+
+  store.append(appended);
+  store.setSourceSize(lastNewline - file.data());
+
+  return appended.size();
+}
+
+TemperatureStore
+TemparatureDataExtractor::parseCsv(const string &path,
+                                   const LoadOptions &options) {
+  // The STREAM path is kept as the reference implementation and always
+  // parses every column.
+  if (options.mode == ReadMode::STREAM) {
+    return readStreamed(path);
+  }
+
+  return readMapped(path, resolveThreads(options.threads),
+                    projectionFor(options.locations));
+}
+
+TemperatureStore TemparatureDataExtractor::readStreamed(const string &path) {
+  TemperatureStore store{};
   vector<string> rows = FileReader::read_file(path);
+  store.reserve(rows.size());
+
+  if (!rows.empty()) {
+    checkHeader(StringSpan(rows[0].data(), rows[0].size()));
+  }
+
+  const FieldMask &mask = store.getFieldMask();
+  WeatherRow values;
 
   for (u_int i = 1; i < rows.size(); ++i) {
     const string &row = rows[i];
-    vector<string> tokens = FileReader::tokenise(row, ',');
-    string date = tokens[0];
 
-    for (u_int i = 1; i < tokens.size(); i += 3) {
-      EULocation location = EULocation::uknown;
-      float temperature = -273.15;
+    if (row.empty() ||
+        !WeatherParser::parse(StringSpan(row.data(), row.size()), mask,
+                              values)) {
+      continue;
+    }
+
+    store.appendRow(values);
+  }
+
+  // getline gives no byte count, so follow mode resumes from the size the
+  // file has once it has been read.
+  struct stat info;
+  if (stat(path.c_str(), &info) == 0) {
+    store.setSourceSize(info.st_size);
+  }
+
+  return store;
+}
+
+TemperatureStore
+TemparatureDataExtractor::readMapped(const string &path, u_int threads,
+                                     const vector<bool> &projection,
+                                     size_t limit) {
+  TemperatureStore store{};
+  store.setLoadedColumns(projection);
+  MappedFile file{path};
 
-      temperature = stof(tokens[i]);
-      location = static_cast<EULocation>(floor(i / 3));
+  if (!file.isOpen()) {
+    return store;
+  }
 
-      points.emplace_back(location, temperature, date);
+  const char *cursor = file.data();
+  const char *end = cursor + min(file.size(), limit);
+  store.setSourceSize(end - cursor);
+
+  StringSpan header;
+  if (!FileReader::nextLine(cursor, end, header)) {
+    return store;
+  }
+
+  checkHeader(header);
+
+  size_t rowLength = header.size + 1;
+
+  // Tiny files are not worth a thread each.
+  size_t maxThreads = (end - cursor) / (rowLength * 64);
+  threads = max<size_t>(1, min<size_t>(threads, maxThreads));
+
+  if (threads <= 1) {
+    store.reserve((end - cursor) / rowLength);
+    parseRows(cursor, end, store);
+    return store;
+  }
+
+  // Newline-aligned byte ranges, each parsed into its own store and merged
+  // back in file order so the result matches the serial path exactly.
+  vector<const char *> bounds{cursor};
+  size_t chunkSize = (end - cursor) / threads;
+
+  for (u_int i = 1; i < threads; ++i) {
+    const char *split = max(bounds.back(), cursor + chunkSize * i);
+    const char *newline =
+        static_cast<const char *>(memchr(split, '\n', end - split));
+    bounds.push_back(newline != nullptr ? newline + 1 : end);
+  }
+  bounds.push_back(end);
+
+  vector<TemperatureStore> chunks(threads);
+  vector<thread> workers{};
+
+  for (TemperatureStore &chunk : chunks) {
+    chunk.setLoadedColumns(projection);
+  }
+
+  for (u_int i = 0; i < threads; ++i) {
+    workers.emplace_back([&bounds, &chunks, rowLength, i]() {
+      chunks[i].reserve((bounds[i + 1] - bounds[i]) / rowLength);
+      parseRows(bounds[i], bounds[i + 1], chunks[i]);
+    });
+  }
+
+  for (thread &worker : workers) {
+    worker.join();
+  }
+
+  size_t rows = 0;
+  for (const TemperatureStore &chunk : chunks) {
+    rows += chunk.size();
+  }
+
+  store.reserve(rows);
+  for (const TemperatureStore &chunk : chunks) {
+    store.append(chunk);
+  }
+
+  return store;
+}
+
+void TemparatureDataExtractor::parseRows(const char *begin, const char *end,
+                                         TemperatureStore &store) {
+  const FieldMask &mask = store.getFieldMask();
+  StringSpan row;
+  WeatherRow values;
+
+  while (FileReader::nextLine(begin, end, row)) {
+    if (row.empty() || !WeatherParser::parse(row, mask, values)) {
+      continue;
     }
+
+    store.appendRow(values);
+  }
+}
+
+void TemparatureDataExtractor::checkHeader(const StringSpan &header) {
+  auto *logger = Logger::getInstance(EnvType::PROD);
+
+  // Columns are read by position, a different header is only reported.
+  if (!WeatherParser::checkHeader(header)) {
+    logger->log("CSV header does not match the weather schema");
   }
+}
+
+TemperatureStore::TemperatureStore()
+    : loadedColumns(LOCATIONS_AMOUNT, true),
+      fieldMask(WeatherParser::makeMask()) {}
+
+void TemperatureStore::reserve(size_t rows) { data.reserve(rows, fieldMask); }
+
+void TemperatureStore::append(const TemperatureStore &other) {
+  if (other.size() == 0) {
+    return;
+  }
+
+  data.append(other.data, fieldMask);
+  ++version;
+}
+
+void TemperatureStore::appendTimestamps(const int64_t *values, size_t count) {
+  TimestampColumn &timestamps = data.column<0>();
+  timestamps.append(values, values + count);
+  data.setSize(timestamps.size());
+  ++version;
+}
+
+void TemperatureStore::viewColumns(const int64_t *timestamps,
+                                   const float *const *temperatures,
+                                   size_t rows,
+                                   const shared_ptr<const void> &owner) {
+  data.column<0>().view(timestamps, rows, owner);
+
+  for (u_int i = 0; i < LOCATIONS_AMOUNT; ++i) {
+    get<0>(data.column<1>()[i]).view(temperatures[i], rows, owner);
+  }
+
+  data.setSize(rows);
+  ++version;
+}
+
+const TemperatureColumn &
+TemperatureStore::getColumn(EULocation location) const {
+  if (location >= LOCATIONS_AMOUNT) {
+    throw invalid_argument("Invalid EULocation enum value");
+  }
+
+  if (!loadedColumns[location]) {
+    throw logic_error("Location column is not loaded");
+  }
+
+  return get<0>(data.column<1>()[location]);
+}
+
+bool TemperatureStore::isLoaded(EULocation location) const {
+  return location < LOCATIONS_AMOUNT && loadedColumns[location];
+}
+
+bool TemperatureStore::isComplete() const {
+  return find(loadedColumns.begin(), loadedColumns.end(), false) ==
+         loadedColumns.end();
+}
+
+void TemperatureStore::setLoadedColumns(const vector<bool> &_loadedColumns) {
+  loadedColumns = _loadedColumns;
+  fieldMask = WeatherParser::makeMask(WeatherColumns::projection(loadedColumns));
+}
+
+void TemperatureStore::setColumn(EULocation location,
+                                 TemperatureColumn &&column) {
+  if (column.size() != size()) {
+    throw invalid_argument("Column does not match the timestamp column");
+  }
+
+  get<0>(data.column<1>()[location]) = move(column);
+  ++version;
+
+  vector<bool> columns = loadedColumns;
+  columns[location] = true;
+  setLoadedColumns(columns);
+}
+
+void TemperatureStore::setSource(const string &path,
+                                 const LoadOptions &options) {
+  sourcePath = path;
+  sourceOptions = options;
+}
+
+TemperaturePoint TemperatureStore::getPoint(size_t row,
+                                            EULocation location) const {
+  return TemperaturePoint(location, getColumn(location)[row],
+                          DateTimeProcessor::toIsoString(getTimestamps()[row]));
+}
 
-  return points;
+void TemperaturePointsState::setData(const TemperatureStore &_store) {
+  this->store = &_store;
 }
 
-void TemperaturePointsState::setData(const vector<TemperaturePoint> &_points) {
-  this->points = vector<TemperaturePoint>(_points);
+const TemperatureStore &TemperaturePointsState::getData() {
+  return *this->store;
 }
 
-const vector<TemperaturePoint> &TemperaturePointsState::getData() {
-  return this->points;
+const TemperatureColumn &
+TemperaturePointsState::getColumn(EULocation location) {
+  return this->store->getColumn(location);
 }
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "../utils/fileReader.h"
+#include "./weatherSchema.h"
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -60,19 +64,115 @@ private:
   string date;
 };
 
+class LoadOptions {
+public:
+  LoadOptions(ReadMode _mode = ReadMode::MAPPED, u_int _threads = 1,
+              bool _snapshot = true,
+              const vector<EULocation> &_locations = vector<EULocation>())
+      : mode(_mode), threads(_threads), snapshot(_snapshot),
+        locations(_locations), verifySnapshot(false) {}
+
+  ReadMode mode;
+  // Parser threads for the MAPPED path, 0 picks the hardware concurrency.
+  u_int threads;
+  // Read and refresh the binary snapshot kept next to the CSV.
+  bool snapshot;
+  // Columns to parse up front, empty loads every location. The rest are
+  // parsed on demand by TemparatureDataExtractor::loadLocation.
+  vector<EULocation> locations;
+  // Rehash the snapshot payload before trusting it.
+  bool verifySnapshot;
+};
+
+// Column-oriented storage: one shared epoch-seconds timestamp column plus one
+// contiguous temperature column per EULocation, all indexed by the same row.
+// The columns are the ColumnStore generated from WeatherSchema.
+class TemperatureStore {
+public:
+  TemperatureStore();
+
+  size_t size() const { return data.size(); }
+  void reserve(size_t rows);
+  void append(const TemperatureStore &other);
+
+  void appendRow(const WeatherRow &row) {
+    data.append(row, fieldMask);
+    ++version;
+  }
+  void appendTimestamps(const int64_t *values, size_t count);
+  // Points the columns at memory kept alive by owner instead of copying it,
+  // temperatures holds one pointer per EULocation.
+  void viewColumns(const int64_t *timestamps, const float *const *temperatures,
+                   size_t rows, const shared_ptr<const void> &owner);
+
+  const TimestampColumn &getTimestamps() const { return data.column<0>(); }
+  const TemperatureColumn &getColumn(EULocation location) const;
+  TemperaturePoint getPoint(size_t row, EULocation location) const;
+
+  bool isLoaded(EULocation location) const;
+  bool isComplete() const;
+  const vector<bool> &getLoadedColumns() const { return loadedColumns; }
+  void setLoadedColumns(const vector<bool> &_loadedColumns);
+  // Schema fields a parser has to fill for the loaded columns.
+  const FieldMask &getFieldMask() const { return fieldMask; }
+  void setColumn(EULocation location, TemperatureColumn &&column);
+
+  // Bumped by every change to the rows or columns, results computed from
+  // the store stay valid while it holds.
+  uint64_t getVersion() const { return version; }
+
+  void setSource(const string &path, const LoadOptions &options);
+  const string &getSourcePath() const { return sourcePath; }
+  const LoadOptions &getSourceOptions() const { return sourceOptions; }
+  // Bytes of the source CSV the store reflects, where tailing resumes.
+  size_t getSourceSize() const { return sourceSize; }
+  void setSourceSize(size_t _sourceSize) { sourceSize = _sourceSize; }
+
+private:
+  ColumnStore<WeatherSchema> data;
+  vector<bool> loadedColumns;
+  FieldMask fieldMask;
+  uint64_t version = 0;
+
+  string sourcePath;
+  LoadOptions sourceOptions;
+  size_t sourceSize = 0;
+};
+
+// Views a store owned elsewhere, which must outlive the state.
 class TemperaturePointsState {
 public:
-  TemperaturePointsState(const vector<TemperaturePoint> &_points)
-      : points(vector<TemperaturePoint>(_points)) {};
+  TemperaturePointsState(const TemperatureStore &_store) : store(&_store) {};
 
-  void setData(const vector<TemperaturePoint> &_points);
-  const vector<TemperaturePoint> &getData();
+  void setData(const TemperatureStore &_store);
+  const TemperatureStore &getData();
+  const TemperatureColumn &getColumn(EULocation location);
 
 private:
-  vector<TemperaturePoint> points;
+  const TemperatureStore *store;
 };
 
 class TemparatureDataExtractor {
 public:
-  static vector<TemperaturePoint> getTemperatures(const string &path);
+  static TemperatureStore
+  getTemperatures(const string &path,
+                  const LoadOptions &options = LoadOptions());
+
+  // Parses a column skipped by a projected load; no-op once it is loaded.
+  static void loadLocation(TemperatureStore &store, EULocation location);
+
+  // Follow mode: parses complete rows appended to the source CSV since the
+  // store was loaded or last polled and returns how many were added.
+  static size_t appendNewRows(TemperatureStore &store);
+
+private:
+  static TemperatureStore parseCsv(const string &path,
+                                   const LoadOptions &options);
+  static TemperatureStore readStreamed(const string &path);
+  static TemperatureStore readMapped(const string &path, u_int threads,
+                                     const vector<bool> &projection,
+                                     size_t limit = SIZE_MAX);
+  static void parseRows(const char *begin, const char *end,
+                        TemperatureStore &store);
+  static void checkHeader(const StringSpan &header);
 };
@@ -0,0 +1,189 @@
+#include "./temperatureSnapshot.h"
+#include "../utils/fileReader.h"
+#include "../utils/logger.h"
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+static const char SNAPSHOT_MAGIC[8] = {'W', 'X', 'S', 'N', 'A', 'P', 0, 0};
+
+string TemperatureSnapshot::pathFor(const string &csvPath) {
+  return csvPath + ".snapshot";
+}
+
+uint64_t TemperatureSnapshot::hash(const char *data, size_t size) {
+  // 64-bit FNV-1a style mix over 8-byte words.
+  const uint64_t prime = 0x100000001b3ULL;
+  uint64_t result = 0xcbf29ce484222325ULL ^ size;
+
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(word));
+    result = (result ^ word) * prime;
+    result ^= result >> 29;
+  }
+
+  for (; i < size; ++i) {
+    result = (result ^ static_cast<unsigned char>(data[i])) * prime;
+  }
+
+  return result;
+}
+
+bool TemperatureSnapshot::describeCsv(const string &csvPath, size_t parsedSize,
+                                      SnapshotHeader &header) {
+  struct stat info;
+  if (stat(csvPath.c_str(), &info) != 0) {
+    return false;
+  }
+
+  MappedFile csv{csvPath};
+  if (!csv.isOpen() || csv.size() < parsedSize) {
+    return false;
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.locations = LOCATIONS_AMOUNT;
+  header.csvSize = parsedSize;
+  header.csvModifiedSeconds = info.st_mtim.tv_sec;
+  header.csvModifiedNanoseconds = info.st_mtim.tv_nsec;
+  header.csvHash = hash(csv.data(), parsedSize);
+
+  return true;
+}
+
+bool TemperatureSnapshot::load(const string &csvPath, TemperatureStore &store,
+                               bool verify) {
+  auto *logger = Logger::getInstance(EnvType::PROD);
+
+  // Shared so the store's columns can keep viewing the mapping.
+  shared_ptr<MappedFile> snapshot = make_shared<MappedFile>(pathFor(csvPath));
+  if (!snapshot->isOpen() || snapshot->size() < sizeof(SnapshotHeader)) {
+    return false;
+  }
+
+  SnapshotHeader header;
+  memcpy(&header, snapshot->data(), sizeof(header));
+
+  if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != SNAPSHOT_VERSION ||
+      header.locations != LOCATIONS_AMOUNT) {
+    logger->log("Snapshot has an unknown format, falling back to CSV");
+    return false;
+  }
+
+  const uint64_t rows = header.rows;
+  const uint64_t payloadSize =
+      rows * sizeof(int64_t) + rows * LOCATIONS_AMOUNT * sizeof(float);
+
+  if (rows > snapshot->size() ||
+      snapshot->size() != sizeof(SnapshotHeader) + payloadSize) {
+    logger->log("Snapshot is truncated, falling back to CSV");
+    return false;
+  }
+
+  struct stat info;
+  if (stat(csvPath.c_str(), &info) != 0 ||
+      header.csvSize != static_cast<uint64_t>(info.st_size)) {
+    logger->log("Snapshot is stale, falling back to CSV");
+    return false;
+  }
+
+  // Matching size and mtime are trusted as is. Only a CSV that was touched
+  // since the snapshot was written is read again to compare its content.
+  if (header.csvModifiedSeconds != info.st_mtim.tv_sec ||
+      header.csvModifiedNanoseconds != info.st_mtim.tv_nsec) {
+    SnapshotHeader current;
+    if (!describeCsv(csvPath, header.csvSize, current) ||
+        current.csvHash != header.csvHash) {
+      logger->log("Snapshot does not match CSV content, falling back to CSV");
+      return false;
+    }
+  }
+
+  const char *payload = snapshot->data() + sizeof(SnapshotHeader);
+  if (verify && hash(payload, payloadSize) != header.payloadHash) {
+    logger->log("Snapshot is corrupt, falling back to CSV");
+    return false;
+  }
+
+  const int64_t *timestamps = reinterpret_cast<const int64_t *>(payload);
+  payload += rows * sizeof(int64_t);
+
+  const float *temperatures[LOCATIONS_AMOUNT];
+  for (u_int i = 0; i < LOCATIONS_AMOUNT; ++i) {
+    temperatures[i] = reinterpret_cast<const float *>(payload);
+    payload += rows * sizeof(float);
+  }
+
+  TemperatureStore loaded{};
+  loaded.viewColumns(timestamps, temperatures, rows, snapshot);
+  loaded.setSourceSize(header.csvSize);
+  store = move(loaded);
+
+  return true;
+}
+
+bool TemperatureSnapshot::save(const string &csvPath,
+                               const TemperatureStore &store) {
+  auto *logger = Logger::getInstance(EnvType::PROD);
+
+  // Rows appended while the CSV was parsed are not in the store, so the
+  // header describes only the bytes that were parsed. A CSV that grew since
+  // then no longer matches csvSize and is parsed again on the next load.
+  SnapshotHeader header;
+  if (!describeCsv(csvPath, store.getSourceSize(), header)) {
+    return false;
+  }
+
+  const uint64_t rows = store.size();
+  header.rows = rows;
+
+  // Hash the payload in the same order it is laid out on disk.
+  vector<char> payload(rows * sizeof(int64_t) +
+                       rows * LOCATIONS_AMOUNT * sizeof(float));
+  char *cursor = payload.data();
+
+  memcpy(cursor, store.getTimestamps().data(), rows * sizeof(int64_t));
+  cursor += rows * sizeof(int64_t);
+
+  for (u_int i = 0; i < LOCATIONS_AMOUNT; ++i) {
+    const TemperatureColumn &column =
+        store.getColumn(static_cast<EULocation>(i));
+    if (column.size() != rows) {
+      return false;
+    }
+
+    memcpy(cursor, column.data(), rows * sizeof(float));
+    cursor += rows * sizeof(float);
+  }
+
+  header.payloadHash = hash(payload.data(), payload.size());
+
+  // Write to a temporary file first so a crash never leaves a half-written
+  // snapshot under the real name.
+  const string path = pathFor(csvPath);
+  const string temporaryPath = path + ".tmp";
+
+  FILE *file = fopen(temporaryPath.c_str(), "wb");
+  if (file == nullptr) {
+    logger->log("Could not write snapshot " + path);
+    return false;
+  }
+
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 (payload.empty() ||
+                  fwrite(payload.data(), payload.size(), 1, file) == 1);
+  written = fclose(file) == 0 && written;
+
+  if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    remove(temporaryPath.c_str());
+    logger->log("Could not write snapshot " + path);
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "./temperaturePoint.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+#define SNAPSHOT_VERSION 1
+
+// Binary cache of a parsed CSV, written next to it as "<csv>.snapshot".
+// Layout: SnapshotHeader, the timestamp column (int64 x rows), then one
+// float column per location (float x rows each), all in native byte order.
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t locations;
+  uint64_t rows;
+  uint64_t csvSize;
+  int64_t csvModifiedSeconds;
+  int64_t csvModifiedNanoseconds;
+  uint64_t csvHash;
+  uint64_t payloadHash;
+};
+
+class TemperatureSnapshot {
+public:
+  static string pathFor(const string &csvPath);
+
+  // Fills store and returns true only when the snapshot exists and matches
+  // the CSV's size and mtime, or its content hash once the mtime moved. The
+  // store views the mapped columns in place. verify also rehashes the
+  // payload, which reads every page of it.
+  static bool load(const string &csvPath, TemperatureStore &store,
+                   bool verify = false);
+  static bool save(const string &csvPath, const TemperatureStore &store);
+
+  static uint64_t hash(const char *data, size_t size);
+
+private:
+  // Describes the first parsedSize bytes of the CSV.
+  static bool describeCsv(const string &csvPath, size_t parsedSize,
+                          SnapshotHeader &header);
+};
@@ -0,0 +1,56 @@
+#include "./timeIndex.h"
+
+// Interpolation probes before switching to plain bisection, which bounds the
+// worst case on badly skewed data to O(log n).
+#define INTERPOLATION_PROBES 4
+
+size_t TimeIndex::lowerBound(int64_t timestamp) const {
+  return search(timestamp, true);
+}
+
+size_t TimeIndex::upperBound(int64_t timestamp) const {
+  return search(timestamp, false);
+}
+
+size_t TimeIndex::search(int64_t timestamp, bool inclusive) const {
+  // Invariant: rows before low are before the target, rows from high on are
+  // at or after it.
+  size_t low = 0;
+  size_t high = timestamps.size();
+  unsigned int probes = 0;
+
+  auto before = [&](size_t row) {
+    return inclusive ? timestamps[row] < timestamp
+                     : timestamps[row] <= timestamp;
+  };
+
+  while (low < high) {
+    size_t probe = low + (high - low) / 2;
+
+    if (probes < INTERPOLATION_PROBES) {
+      ++probes;
+
+      const int64_t first = timestamps[low];
+      const int64_t last = timestamps[high - 1];
+
+      if (timestamp <= first) {
+        probe = low;
+      } else if (timestamp > last) {
+        probe = high - 1;
+      } else {
+        // Doubles keep the product from overflowing on wide ranges.
+        const double fraction = (static_cast<double>(timestamp) - first) /
+                                (static_cast<double>(last) - first);
+        probe = low + static_cast<size_t>(fraction * (high - 1 - low));
+      }
+    }
+
+    if (before(probe)) {
+      low = probe + 1;
+    } else {
+      high = probe;
+    }
+  }
+
+  return low;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "./columnBuffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Row lookups by time over a sorted timestamp column. Hourly data is close
+// to evenly spaced, so interpolation search usually lands on the row in one
+// or two probes; it falls back to bisection when the guesses stop helping.
+class TimeIndex {
+public:
+  TimeIndex(const TimestampColumn &_timestamps) : timestamps(_timestamps) {}
+
+  // First row whose timestamp is >= timestamp.
+  size_t lowerBound(int64_t timestamp) const;
+  // First row whose timestamp is > timestamp.
+  size_t upperBound(int64_t timestamp) const;
+
+private:
+  const TimestampColumn &timestamps;
+
+  // First row in [0, size) for which timestamps[row] >= timestamp, or
+  // > timestamp when inclusive is false.
+  size_t search(int64_t timestamp, bool inclusive) const;
+};
@@ -0,0 +1,40 @@
+#include "./weatherSchema.h"
+
+static const char *LOCATION_CODES[LOCATIONS_AMOUNT] = {
+    "AT", "BE", "BG", "CH", "CZ", "DE", "DK", "EE", "ES", "FI",
+    "FR", "GB", "GR", "HR", "HU", "IE", "IT", "LT", "LU", "LV",
+    "NL", "NO", "PL", "PT", "RO", "SE", "SI", "SK"};
+
+string TemperatureName::name(size_t location) {
+  return string(WeatherColumns::locationCode(location)) + "_temperature";
+}
+
+string RadiationDirectName::name(size_t location) {
+  return string(WeatherColumns::locationCode(location)) +
+         "_radiation_direct_horizontal";
+}
+
+string RadiationDiffuseName::name(size_t location) {
+  return string(WeatherColumns::locationCode(location)) +
+         "_radiation_diffuse_horizontal";
+}
+
+const char *WeatherColumns::locationCode(size_t location) {
+  if (location >= LOCATIONS_AMOUNT) {
+    return "";
+  }
+
+  return LOCATION_CODES[location];
+}
+
+vector<bool> WeatherColumns::projection(const vector<bool> &locations) {
+  vector<bool> fields(WeatherParser::width, false);
+
+  for (size_t location = 0; location < locations.size(); ++location) {
+    if (locations[location]) {
+      fields[temperatureField(location)] = true;
+    }
+  }
+
+  return fields;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "./schema.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define LOCATIONS_AMOUNT 28
+
+struct UtcTimestampName {
+  static string name(size_t) { return "utc_timestamp"; }
+};
+
+struct TemperatureName {
+  static string name(size_t location);
+};
+
+struct RadiationDirectName {
+  static string name(size_t location);
+};
+
+struct RadiationDiffuseName {
+  static string name(size_t location);
+};
+
+// weather_data.csv: a timestamp followed by temperature and two radiation
+// readings per EULocation, in enum order. Radiation is never stored.
+typedef Schema<Column<TimestampType, UtcTimestampName>,
+               Repeat<LOCATIONS_AMOUNT, Column<FloatType, TemperatureName>,
+                      Skip<RadiationDirectName>, Skip<RadiationDiffuseName>>>
+    WeatherSchema;
+
+typedef RowParser<WeatherSchema> WeatherParser;
+typedef WeatherParser::row_type WeatherRow;
+
+class WeatherColumns {
+public:
+  static const char *locationCode(size_t location);
+  static size_t temperatureField(size_t location) { return 1 + location * 3; }
+  // Field projection that parses the temperatures of the given locations.
+  static vector<bool> projection(const vector<bool> &locations);
+};
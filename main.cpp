@@ -1,45 +1,361 @@
+#include "core/candlestickCache.h"
+#include "core/candlestickRangeIndex.h"
+#include "core/columnFile.h"
 #include "ui/graph/graph.h"
+#include "ui/graph/statisticsOverlay.h"
+#include "ui/eventLoop.h"
 #include "ui/menu/menu.h"
+#include "utils/dateTime.h"
 #include "utils/logger.h"
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
 
 using namespace std;
 
-int main() {
+// Candlesticks of filter, from the range index when the temperature range
+// keeps every reading of the column and from the rows otherwise. A given
+// aggregator is built instead, so follow mode can fold appended rows into
+// it later. Runs on a worker while the loop keeps reading keys.
+static vector<Candlestick>
+computeCandlesticks(TemperatureStore &temperatures,
+                    CandlestickRangeIndex &rangeIndex,
+                    CandlestickAggregator *aggregator,
+                    const CandlestickFilter &filter, u_int hoursStep,
+                    BucketUnit unit, u_int threads) {
+  TemparatureDataExtractor::loadLocation(temperatures, filter.location);
+
+  if (aggregator != nullptr) {
+    aggregator->update(temperatures);
+    return aggregator->getCandlesticks();
+  }
+
+  const TemperatureColumn &column = temperatures.getColumn(filter.location);
+  rangeIndex.update(column);
+
+  // The range index holds unfiltered aggregates.
+  const FloatSummary range = rangeIndex.query(column, 0, column.size());
+
+  if (filter.excludes(range.lowest, range.highest)) {
+    return CandlestickDataExtractor::getCandlesticks(temperatures, filter,
+                                                     hoursStep, unit, threads);
+  }
+
+  if (unit == BucketUnit::HOURS) {
+    return rangeIndex.getCandlesticks(temperatures.getTimestamps(), column,
+                                      filter.getInterval(), hoursStep);
+  }
+
+  return rangeIndex.getCandlesticks(temperatures.getTimestamps(), column,
+                                    filter.getInterval(), unit);
+}
+
+// Cache of the interactive session, reported when the program exits.
+static const CandlestickCache *sessionCache = nullptr;
+
+static void reportCache() {
+  if (sessionCache == nullptr) {
+    return;
+  }
+
+  cout << "Candlestick cache: " << sessionCache->getHits() << " hits, "
+       << sessionCache->getMisses() << " misses" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  LoadOptions loadOptions{ReadMode::MAPPED, 0};
+  bool projectLocations = false;
+  bool follow = false;
+  string dataPath = "./datasets/weather_data.csv";
+  string exportPath{};
+  string reportPath{};
+  size_t cacheBytes = DEFAULT_CANDLESTICK_CACHE_BYTES;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--stream") == 0) {
+      loadOptions.mode = ReadMode::STREAM;
+    } else if (strcmp(argv[i], "--no-snapshot") == 0) {
+      loadOptions.snapshot = false;
+    } else if (strcmp(argv[i], "--verify-snapshot") == 0) {
+      loadOptions.verifySnapshot = true;
+    } else if (strcmp(argv[i], "--follow") == 0) {
+      follow = true;
+    } else if (strcmp(argv[i], "--project") == 0) {
+      projectLocations = true;
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      loadOptions.threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--data") == 0 && i + 1 < argc) {
+      dataPath = argv[++i];
+    } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+      exportPath = argv[++i];
+    } else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+      reportPath = argv[++i];
+    } else if (strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc) {
+      cacheBytes = size_t(atoi(argv[++i])) * 1024 * 1024;
+    }
+  }
+
+  Logger::getInstance(EnvType::PROD)
+      ->log(string("Candlestick reduction kernel: ") +
+            SimdReduction::implementation());
+
   GraphParametersDTO graphParameters{10, 10};
   vector<FilterDTO<string>> filters{
       FilterDTO<string>("1980-01-01T00:00:00Z|2019-12-31T23:00:00Z",
                         FilterType::timeRange),
       FilterDTO<string>(LocationEnumProcessor::locationToString(EULocation::de),
-                        FilterType::location)};
+                        FilterType::location),
+      FilterDTO<string>(DEFAULT_TEMPERATURE_RANGE,
+                        FilterType::temperatureRange)};
+
+  // Converting to a column file or reporting needs every location.
+  if (projectLocations && exportPath.empty() && reportPath.empty()) {
+    loadOptions.locations = {CandlestickDataExtractor::getLocation(filters)};
+  }
+
+  TemperatureStore temperatures{
+      TemparatureDataExtractor::getTemperatures(dataPath, loadOptions)};
+
+  if (!exportPath.empty()) {
+    if (!TemperatureColumnFile::save(exportPath, temperatures)) {
+      cerr << "Could not write " << exportPath << endl;
+      return 1;
+    }
+
+    cout << "Wrote " << temperatures.size() << " rows to " << exportPath
+         << endl;
+    return 0;
+  }
+
+  // Monthly candlesticks of every country over the default date range.
+  if (!reportPath.empty()) {
+    const DateInterval interval =
+        CandlestickDataExtractor::getDateInterval(filters);
+    const map<EULocation, vector<Candlestick>> report =
+        CandlestickDataExtractor::getLocationCandlesticks(
+            temperatures, {}, &interval, 1, graphParameters.getBucketUnit(),
+            loadOptions.threads);
+
+    ofstream file{reportPath};
+    file << "location,timestamp,open,high,low,close\n";
+
+    for (const auto &series : report) {
+      const string location =
+          LocationEnumProcessor::locationToString(series.first);
+
+      for (const Candlestick &candlestick : series.second) {
+        file << location << ','
+             << DateTimeProcessor::toIsoString(candlestick.timestamp) << ','
+             << candlestick.open << ',' << candlestick.high << ','
+             << candlestick.low << ',' << candlestick.close << '\n';
+      }
+    }
+
+    if (!file) {
+      cerr << "Could not write " << reportPath << endl;
+      return 1;
+    }
+
+    cout << "Wrote " << report.size() << " locations to " << reportPath
+         << endl;
+    return 0;
+  }
 
   TemperatureMenuDataTransfer parser{&graphParameters, &filters};
 
   MenuOptions options{true, false};
 
+  // Registered before the renderer, so it runs after the terminal is reset.
+  atexit(reportCache);
+
   Canvas canvas{};
   Renderer renderer{canvas};
 
-  vector<TemperaturePoint> temperatures{
-      TemparatureDataExtractor::getTemperatures("./datasets/weather_data.csv")};
-
   vector<Candlestick> candlesticks{
-      CandlestickDataExtractor::getCandlesticks(temperatures, 24 * 31)};
+      CandlestickDataExtractor::getCandlesticks(
+          temperatures, 24 * 31, EULocation::de, loadOptions.threads)};
 
   Graph graph{candlesticks, &graphParameters, &filters};
+  StatisticsOverlay overlay{graph, &graphParameters};
 
-  const vector<IRenderable *> renderables{&graph};
+  // The overlay goes first so the candlesticks are drawn over it.
+  const vector<IRenderable *> renderables{&overlay, &graph};
 
   Menu *menu = Menu::getInstance(parser, options);
 
+  // One range index per visited location, so changing the bucket size or the
+  // date range never walks the hourly rows again.
+  map<EULocation, CandlestickRangeIndex> rangeIndexes{};
+  CandlestickCache cache{cacheBytes};
+  sessionCache = &cache;
+
+  // Filters are compiled again only after the menu changes them.
+  vector<FilterDTO<string>> compiledFilters{};
+  CandlestickFilter filter{};
+
+  // Follow mode checks the file for new rows once a second.
+  EventLoop events{};
+  if (follow) {
+    events.setTimer(1000);
+  }
+
+  // Keys read but not handled yet, and what needs drawing again.
+  string keys{};
+  GraphParametersDTO drawnParameters = graphParameters;
+  bool graphDirty = true;
+  bool menuDirty = true;
+
+  // A cache miss is computed on a worker, which notifies the loop when it
+  // is done. While it runs the loop only handles keys and the menu: the
+  // worker owns the store and the range indexes, so follow mode polls wait
+  // for it. Its result is kept in case the cache does not take it.
+  future<vector<Candlestick>> pending{};
+  bool computing = false;
+  bool appendDue = false;
+  CandlestickFilter pendingFilter{};
+  CandlestickQuery pendingQuery{filter, 0, BucketUnit::HOURS, 0};
+  vector<Candlestick> computed{};
+  CandlestickQuery computedQuery = pendingQuery;
+  bool hasComputed = false;
+
+  // Follow mode aggregates the last computed query incrementally: appended
+  // rows only touch its last buckets, and the result goes to the cache.
+  unique_ptr<CandlestickAggregator> followed{};
+  CandlestickQuery followedQuery = pendingQuery;
+
+  // End of input leaves the way 'q' does: Graph and the menu parser own
+  // pointers to graphParameters and filters, so main's locals must not be
+  // destroyed. The worker still reads the store until it is waited out.
+  auto quit = [&pending, &computing]() {
+    if (computing) {
+      pending.wait();
+    }
+    exit(0);
+  };
+
   while (true) {
-    graph.setCandlesticks(CandlestickDataExtractor::getCandlesticks(
-        temperatures, filters, 24 * 31));
-    renderer.render(renderables);
-    menu->run();
-    renderer.clearCanvas();
-    cout << "\x1B[2J\x1B[H";
+    // Keys that came in while the last frame was computed are handled
+    // together, before anything is computed or drawn again.
+    if (events.hasInput() && !events.readInput(keys)) {
+      quit();
+    }
+
+    if (!keys.empty()) {
+      menuDirty = menu->handleKeys(keys) || menuDirty;
+      keys.clear();
+      graphDirty = graphDirty || filters != compiledFilters ||
+                   graphParameters != drawnParameters;
+      continue;
+    }
+
+    bool graphReady = false;
+
+    if (graphDirty && !computing) {
+      if (filters != compiledFilters) {
+        filter = CandlestickFilter::compile(filters);
+        compiledFilters = filters;
+      }
+
+      const CandlestickQuery query{filter, graphParameters.getHoursStep(),
+                                   graphParameters.getBucketUnit(),
+                                   temperatures.getVersion()};
+      const bool fresh = hasComputed && !(query < computedQuery) &&
+                         !(computedQuery < query);
+      const vector<Candlestick> *cached =
+          fresh ? &computed : cache.find(query);
+
+      if (cached != nullptr) {
+        graph.setCandlesticks(*cached);
+        graphReady = true;
+      } else {
+        CandlestickRangeIndex *rangeIndex = &rangeIndexes[filter.location];
+        pendingFilter = filter;
+        pendingQuery = query;
+        computing = true;
+
+        CandlestickAggregator *aggregator = nullptr;
+        if (follow) {
+          followed.reset(
+              new CandlestickAggregator{filter, query.hoursStep, query.unit});
+          aggregator = followed.get();
+        }
+
+        pending = async(launch::async, [&temperatures, &events, &pendingFilter,
+                                        &loadOptions, rangeIndex, aggregator,
+                                        query]() {
+          vector<Candlestick> result = computeCandlesticks(
+              temperatures, *rangeIndex, aggregator, pendingFilter,
+              query.hoursStep, query.unit, loadOptions.threads);
+          events.notify();
+          return result;
+        });
+      }
+
+      hasComputed = false;
+    }
+
+    if (graphReady) {
+      renderer.render(renderables);
+      renderer.clearCanvas();
+      drawnParameters = graphParameters;
+      graphDirty = false;
+      menuDirty = true;
+    } else if (menuDirty) {
+      renderer.clearMenu();
+    }
+
+    if (menuDirty) {
+      menu->render();
+      menuDirty = false;
+    }
+
+    const LoopEvents happened = events.wait();
+
+    if (happened.resized) {
+      renderer.resize();
+      graphDirty = true;
+    }
+
+    if (happened.input && !events.readInput(keys)) {
+      quit();
+    }
+
+    if (happened.notified && computing) {
+      // The worker notifies right before returning, get waits out the rest.
+      computed = pending.get();
+      computing = false;
+
+      // Loading the column may have moved the version, so the result is
+      // keyed once the worker is done.
+      computedQuery = pendingQuery;
+      computedQuery.version = temperatures.getVersion();
+      hasComputed = true;
+      cache.insert(computedQuery, computed);
+      followedQuery = computedQuery;
+    }
+
+    appendDue = appendDue || happened.timer;
+    if (appendDue && !computing) {
+      const uint64_t version = temperatures.getVersion();
+      TemparatureDataExtractor::appendNewRows(temperatures);
+
+      if (temperatures.getVersion() != version) {
+        graphDirty = true;
+
+        // The next frame of the followed query is then a cache hit.
+        if (followed && followedQuery.version == version) {
+          followed->update(temperatures);
+          followedQuery.version = temperatures.getVersion();
+          cache.insert(followedQuery, followed->getCandlesticks());
+        }
+      }
+
+      appendDue = false;
+    }
   }
 }
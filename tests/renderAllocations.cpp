@@ -0,0 +1,101 @@
+// Frames of the same size must not allocate: the canvas, the renderer's
+// buffers and the graph's scratch are all reused. Every global operator new
+// is counted while the graph and its overlay are drawn over and over.
+
+#include "../ui/graph/graph.h"
+#include "../ui/graph/statisticsOverlay.h"
+#include "../ui/renderer.h"
+#include "../utils/dateTime.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#define WARMUP_FRAMES 4
+#define MEASURED_FRAMES 100
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+  ++allocations;
+  void *memory = malloc(size != 0 ? size : 1);
+  if (memory == nullptr) {
+    throw bad_alloc();
+  }
+
+  return memory;
+}
+
+void operator delete(void *memory) noexcept { free(memory); }
+void operator delete(void *memory, size_t) noexcept { free(memory); }
+
+static vector<Candlestick> makeCandlesticks(size_t count) {
+  vector<Candlestick> candlesticks{};
+  for (size_t i = 0; i < count; ++i) {
+    const float close = 10 + 8 * sinf(i * 0.07f) + (i % 7) * 0.3f;
+    candlesticks.emplace_back(315532800 + int64_t(i) * SECONDS_IN_DAY,
+                              close - 1, close + 3, close - 3, close);
+  }
+
+  return candlesticks;
+}
+
+// Alternates between two x element counts so every frame has changes to
+// send, and returns how many allocations the measured frames made.
+static size_t measure(Renderer &renderer,
+                      const vector<IRenderable *> &renderables,
+                      GraphParametersDTO &parameters) {
+  for (int frame = 0; frame < WARMUP_FRAMES; ++frame) {
+    parameters.setXElements(frame % 2 == 0 ? 10 : 12);
+    renderer.render(renderables);
+    renderer.clearCanvas();
+  }
+
+  const size_t before = allocations;
+  for (int frame = 0; frame < MEASURED_FRAMES; ++frame) {
+    parameters.setXElements(frame % 2 == 0 ? 10 : 12);
+    renderer.render(renderables);
+    renderer.clearCanvas();
+  }
+
+  return allocations - before;
+}
+
+int main() {
+  // The frames are not meant to be seen; this also fixes the canvas at its
+  // default size.
+  if (freopen("/dev/null", "w", stdout) == nullptr) {
+    fprintf(stderr, "could not redirect stdout\n");
+    return 1;
+  }
+
+  // Graph takes ownership of both.
+  GraphParametersDTO *parameters = new GraphParametersDTO{10, 4};
+  auto *filters = new vector<FilterDTO<string>>{};
+  Graph graph{makeCandlesticks(2000), parameters, filters};
+  StatisticsOverlay overlay{graph, parameters};
+  Renderer renderer{Canvas()};
+  const vector<IRenderable *> renderables{&overlay, &graph};
+
+  const DecimationMode modes[] = {DecimationMode::PAGED,
+                                  DecimationMode::MIN_MAX,
+                                  DecimationMode::LTTB};
+  int failures = 0;
+
+  for (DecimationMode mode : modes) {
+    parameters->setDecimation(mode);
+    const size_t made = measure(renderer, renderables, *parameters);
+
+    if (made != 0) {
+      fprintf(stderr, "FAIL %s: %zu allocations in %d frames\n",
+              Decimation::modeToString(mode).c_str(), made, MEASURED_FRAMES);
+      ++failures;
+    }
+  }
+
+  if (failures == 0) {
+    fprintf(stderr, "PASS renderAllocations\n");
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include "eventLoop.h"
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+// Bytes taken from stdin per read.
+#define INPUT_CHUNK 256
+
+static int resizePipe[2] = {-1, -1};
+
+static void makeNonBlocking(int descriptors[2]) {
+  for (int i = 0; i < 2; ++i) {
+    fcntl(descriptors[i], F_SETFL, fcntl(descriptors[i], F_GETFL) | O_NONBLOCK);
+    fcntl(descriptors[i], F_SETFD, FD_CLOEXEC);
+  }
+}
+
+// Empties a non-blocking pipe of wake-up bytes.
+static void drain(int descriptor) {
+  char bytes[16];
+  while (read(descriptor, bytes, sizeof(bytes)) > 0) {
+  }
+}
+
+static void onResize(int) {
+  const int savedErrno = errno;
+  const char byte = 0;
+  // The pipe is non-blocking, a full pipe already holds a wake-up.
+  const ssize_t written = write(resizePipe[1], &byte, 1);
+  (void)written;
+  errno = savedErrno;
+}
+
+EventLoop::EventLoop() : timerInterval(0), notifyPipe{-1, -1} {
+  if (pipe(notifyPipe) == 0) {
+    makeNonBlocking(notifyPipe);
+  }
+
+  if (resizePipe[0] < 0 && pipe(resizePipe) == 0) {
+    makeNonBlocking(resizePipe);
+
+    // Restarted, so a resize during line input does not fail the read.
+    struct sigaction action {};
+    action.sa_handler = onResize;
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGWINCH, &action, nullptr);
+  }
+}
+
+EventLoop::~EventLoop() {
+  for (int end : notifyPipe) {
+    if (end >= 0) {
+      close(end);
+    }
+  }
+}
+
+void EventLoop::setTimer(int intervalMs) {
+  timerInterval = chrono::milliseconds(intervalMs);
+  timerDeadline = chrono::steady_clock::now() + timerInterval;
+}
+
+int EventLoop::timeUntilTimer() const {
+  if (timerInterval.count() == 0) {
+    return -1;
+  }
+
+  const auto remaining = chrono::duration_cast<chrono::milliseconds>(
+      timerDeadline - chrono::steady_clock::now());
+  return remaining.count() > 0 ? remaining.count() : 0;
+}
+
+LoopEvents EventLoop::wait() {
+  LoopEvents events{};
+
+  while (!events.input && !events.resized && !events.timer &&
+         !events.notified) {
+    struct pollfd descriptors[3] = {{STDIN_FILENO, POLLIN, 0},
+                                    {resizePipe[0], POLLIN, 0},
+                                    {notifyPipe[0], POLLIN, 0}};
+    const int ready = poll(descriptors, 3, timeUntilTimer());
+
+    // A closed stdin reads as input, readInput then reports its end.
+    if (ready < 0 && errno != EINTR) {
+      events.input = true;
+      break;
+    }
+
+    if (ready > 0) {
+      events.input = descriptors[0].revents != 0;
+      if (descriptors[1].revents & POLLIN) {
+        drain(resizePipe[0]);
+        events.resized = true;
+      }
+      if (descriptors[2].revents & POLLIN) {
+        drain(notifyPipe[0]);
+        events.notified = true;
+      }
+    }
+
+    if (timerInterval.count() != 0 &&
+        chrono::steady_clock::now() >= timerDeadline) {
+      events.timer = true;
+      timerDeadline = chrono::steady_clock::now() + timerInterval;
+    }
+  }
+
+  return events;
+}
+
+bool EventLoop::hasInput() const {
+  struct pollfd descriptor = {STDIN_FILENO, POLLIN, 0};
+  return poll(&descriptor, 1, 0) > 0;
+}
+
+bool EventLoop::readInput(string &keys) const {
+  char chunk[INPUT_CHUNK];
+
+  while (hasInput()) {
+    const ssize_t size = read(STDIN_FILENO, chunk, sizeof(chunk));
+    if (size == 0) {
+      return false;
+    }
+
+    if (size < 0) {
+      return errno == EINTR || errno == EAGAIN;
+    }
+
+    keys.append(chunk, size);
+    if (size < INPUT_CHUNK) {
+      break;
+    }
+  }
+
+  return true;
+}
+
+void EventLoop::notify() {
+  const char byte = 0;
+  // A full pipe already holds a wake-up.
+  const ssize_t written = write(notifyPipe[1], &byte, 1);
+  (void)written;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+// What ended one EventLoop::wait, several can be set at once.
+class LoopEvents {
+public:
+  bool input;
+  bool resized;
+  bool timer;
+  bool notified;
+};
+
+// Waits on stdin, terminal resizes, a repeating timer and notifications
+// from other threads with one poll(). SIGWINCH is turned into a readable
+// pipe, so a resize wakes the loop without a key press and without work
+// inside the signal handler; notify() writes to a pipe of its own.
+class EventLoop {
+public:
+  EventLoop();
+  ~EventLoop();
+
+  EventLoop(const EventLoop &) = delete;
+  EventLoop &operator=(const EventLoop &) = delete;
+
+  // Fires every intervalMs from now on, 0 turns the timer off.
+  void setTimer(int intervalMs);
+  // Blocks until at least one event happened.
+  LoopEvents wait();
+  // True when keys are already waiting, never blocks.
+  bool hasInput() const;
+  // Appends every key already waiting to keys, never blocks. False once
+  // stdin is closed.
+  bool readInput(string &keys) const;
+  // Wakes wait with notified set. Safe to call from any thread; one sent
+  // before wait runs is kept, several in a row collapse into one.
+  void notify();
+
+private:
+  chrono::milliseconds timerInterval;
+  chrono::steady_clock::time_point timerDeadline;
+  int notifyPipe[2];
+
+  int timeUntilTimer() const;
+};
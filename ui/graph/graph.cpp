@@ -1,6 +1,8 @@
 #include "graph.h"
-#include "../../utils/logger.h"
+#include "../../utils/dateTime.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <string>
 #include <vector>
@@ -8,152 +10,162 @@
 #define Y_THRESHOLD 7
 #define X_THRESHOLD 8
 
-vector<RenderPoint> Graph::render(const Canvas &canvas) const {
-  int width = canvas.getWidth();
-  int height = canvas.getHeight();
-
-  vector<RenderPoint> renderPoints{};
-
-  renderPoints = renderAxes(canvas);
-  const vector<RenderPoint> &candlesticks = renderCandlesticks(canvas);
-  renderPoints.insert(renderPoints.end(), candlesticks.begin(),
-                      candlesticks.end());
-
-  return renderPoints;
+void Graph::draw(Surface &surface) const {
+  renderAxes(surface);
+  renderCandlesticks(surface);
 }
 
-vector<RenderPoint> Graph::renderCandlesticks(const Canvas &canvas) const {
-  vector<RenderPoint> renderPoints{};
-
-  int width = canvas.getWidth();
-  int height = canvas.getHeight();
+void Graph::renderCandlesticks(Surface &surface) const {
+  int width = surface.getWidth();
+  int height = surface.getHeight();
 
   u_int xElementsAmount = this->graphParameters->getXElements();
   u_int yElementsAmount = this->graphParameters->getYElements();
 
-  auto *logger = Logger::getInstance(EnvType::PROD);
-  u_int size = this->candlesticks.size();
-
-  int ySteps = floor(height / yElementsAmount);
   int xSteps = floor(width / xElementsAmount);
 
-  vector<Candlestick> paginatedCandlesticks = vector<Candlestick>{
-      this->candlesticks.begin(), this->candlesticks.begin() + xElementsAmount};
+  // A short range or a large step can leave fewer candlesticks than slots.
+  if (this->candlesticks.empty()) {
+    return;
+  }
 
-  float min = CandlestickProcessor::getLowest(paginatedCandlesticks);
-  float max = CandlestickProcessor::getHighest(paginatedCandlesticks);
-  float diff = max - min;
+  if (this->graphParameters->getDecimation() != DecimationMode::PAGED) {
+    renderOverview(surface);
+    return;
+  }
 
-  logger->log("Min: " + to_string(min));
-  logger->log("Max: " + to_string(max));
+  // The page is candlesticks [0, paginated), drawn in place.
+  const int paginated =
+      std::min<size_t>(xElementsAmount, this->candlesticks.size());
+
+  float min;
+  float max;
+  CandlestickProcessor::getBounds(this->candlesticks, 0, paginated, min, max);
+  float diff = max - min;
 
   float tempStep = float(diff / yElementsAmount);
 
-  for (int i = 1; i * xSteps < width && i < paginatedCandlesticks.size(); ++i) {
-    const Candlestick &candlestick = paginatedCandlesticks[i - 1];
+  char date[ISO_STRING_LENGTH + 1];
+  for (int i = 1; i * xSteps < width && i < paginated; ++i) {
+    DateTimeProcessor::formatIso(this->candlesticks[i - 1].timestamp, date);
+    surface.text((i * xSteps) + 1, floor(height / 2) - 1, date,
+                 ISO_STRING_LENGTH - 7);
+  }
+
+  renderScale(surface, min, tempStep);
 
-    for (int j = 0; j < floor(candlestick.date.size() - 7); ++j) {
-      renderPoints.emplace_back((i * xSteps) + j + 1, floor(height / 2) - 1,
-                                candlestick.date[j]);
-    }
+  for (int i = 1; i < paginated; ++i) {
+    renderCandlestick(surface, i * xSteps, this->candlesticks[i - 1], min,
+                      diff);
   }
+}
 
-  for (int i = 0; i * ySteps < height; ++i) {
-    const Candlestick &candlestick = paginatedCandlesticks[i];
+// One candlestick per column over the whole series, decimated to fit.
+void Graph::renderOverview(Surface &surface) const {
+  int width = surface.getWidth();
+  int height = surface.getHeight();
 
-    int exp = floor(log10f(tempStep));
-    int multiplyFactor = 1;
+  int xSteps = floor(width / this->graphParameters->getXElements());
+  int columns = width - Y_THRESHOLD - 1;
+  if (columns <= 0) {
+    return;
+  }
 
-    if (exp < 0 || exp >= 2) {
-      multiplyFactor = powf(10, abs(exp));
-    }
+  Decimation::decimate(this->candlesticks, columns,
+                       this->graphParameters->getDecimation(), decimated);
 
-    string temp =
-        string(to_string(((tempStep * i) + min) * multiplyFactor).substr(0, 5));
-    if (exp != 0) {
-      temp = temp + "e" + to_string(exp);
-    }
+  float min;
+  float max;
+  CandlestickProcessor::getBounds(decimated, min, max);
+  float diff = max > min ? max - min : 1;
 
-    for (int j = temp.size(); j > 0; --j) {
-      renderPoints.emplace_back(temp.size() - j, i * ySteps,
-                                temp[temp.size() - j]);
-    }
+  renderScale(surface, min, diff / this->graphParameters->getYElements());
+
+  for (int i = 0; i < decimated.size(); ++i) {
+    renderCandlestick(surface, Y_THRESHOLD + i + 1, decimated[i], min, diff);
   }
 
-  for (int i = 1; i < paginatedCandlesticks.size(); ++i) {
-    const Candlestick &candlestick = paginatedCandlesticks[i - 1];
+  // The columns touch, so dates go over the candlesticks, no closer than
+  // their own width and at most one per x element.
+  char date[ISO_STRING_LENGTH + 1];
+  for (int i = 0; i < decimated.size();) {
+    DateTimeProcessor::formatIso(decimated[i].timestamp, date);
+    surface.text(Y_THRESHOLD + i + 1, floor(height / 2) - 1, date,
+                 ISO_STRING_LENGTH - 7);
+    i += std::max<int>(xSteps, ISO_STRING_LENGTH - 6);
+  }
+}
 
-    int open = floor(abs((candlestick.open - min) * height) / diff);
-    int close = floor(abs((candlestick.close - min) * height) / diff);
-    int high = floor(abs((candlestick.high - min) * height) / diff);
-    int low = floor(abs((candlestick.low - min) * height) / diff);
+void Graph::renderScale(Surface &surface, float min, float tempStep) const {
+  int height = surface.getHeight();
+  int ySteps = floor(height / this->graphParameters->getYElements());
 
-    for (int j = 0; j < abs(high - low); ++j) {
-      if (high > low) {
-        renderPoints.emplace_back(i * xSteps, low + j, '|');
-      } else {
-        renderPoints.emplace_back(i * xSteps, high + j, '|');
-      }
-    }
+  for (int i = 0; i * ySteps < height; ++i) {
+    int exp = floor(log10f(tempStep));
+    int multiplyFactor = 1;
 
-    for (int j = 0; j < abs(open - close); ++j) {
-      if (open > close) {
-        if (0 == j) {
-          renderPoints.emplace_back(i * xSteps, close + j, 'v');
-          continue;
-        }
-        renderPoints.emplace_back(i * xSteps, close + j, '#');
-      } else {
-        if (j == abs(open - close) - 1) {
-          renderPoints.emplace_back(i * xSteps, open + j, '^');
-          continue;
-        }
-        renderPoints.emplace_back(i * xSteps, open + j, '#');
-      }
+    if (exp < 0 || exp >= 2) {
+      multiplyFactor = powf(10, abs(exp));
     }
 
-    if (open == close) {
-      renderPoints.emplace_back(i * xSteps, close, '#');
+    // Formatted like to_string, cut to five characters, in a buffer on
+    // the stack so a redraw allocates nothing.
+    char label[64];
+    int length = snprintf(label, sizeof(label), "%f",
+                          ((tempStep * i) + min) * multiplyFactor);
+    length = std::min(std::max(length, 0), 5);
+    if (exp != 0) {
+      length += snprintf(label + length, sizeof(label) - length, "e%d", exp);
     }
-  }
 
-  return renderPoints;
+    surface.text(0, i * ySteps, label, length);
+  }
 }
 
-vector<RenderPoint> Graph::renderAxes(const Canvas &canvas) const {
-  vector<RenderPoint> renderPoints{};
+void Graph::renderCandlestick(Surface &surface, int x,
+                              const Candlestick &candlestick, float min,
+                              float diff) const {
+  int height = surface.getHeight();
+
+  int open = floor(abs((candlestick.open - min) * height) / diff);
+  int close = floor(abs((candlestick.close - min) * height) / diff);
+  int high = floor(abs((candlestick.high - min) * height) / diff);
+  int low = floor(abs((candlestick.low - min) * height) / diff);
+
+  surface.verticalSpan(x, std::min(high, low), std::max(high, low), '|');
+
+  // The body runs from the open to the close, its end marks the direction.
+  if (open > close) {
+    surface.verticalSpan(x, close, open, '#');
+    surface.point(x, close, 'v');
+  } else if (open < close) {
+    surface.verticalSpan(x, open, close, '#');
+    surface.point(x, close - 1, '^');
+  } else {
+    surface.point(x, close, '#');
+  }
+}
 
-  int width = canvas.getWidth();
-  int height = canvas.getHeight();
-  auto *logger = Logger::getInstance(EnvType::PROD);
-  u_int size = this->candlesticks.size();
+void Graph::renderAxes(Surface &surface) const {
+  int width = surface.getWidth();
+  int height = surface.getHeight();
 
   int ySteps = floor(height / this->graphParameters->getYElements());
   int xSteps = floor(width / this->graphParameters->getXElements());
 
+  surface.horizontalLine(Y_THRESHOLD, width - 1, floor(height / 2), '-');
+  if (width - 1 >= Y_THRESHOLD) {
+    surface.point(width - 1, floor(height / 2), '>');
+  }
   for (int i = Y_THRESHOLD; i < width; ++i) {
     if (i % xSteps == 0) {
-      renderPoints.emplace_back(i, floor(height / 2), '+');
-      continue;
-    } else if (i == width - 1) {
-      renderPoints.emplace_back(i, floor(height / 2), '>');
-      continue;
-    } else {
-      renderPoints.emplace_back(i, floor(height / 2), '-');
+      surface.point(i, floor(height / 2), '+');
     }
   }
 
-  for (int i = 0; i < height + Y_THRESHOLD; ++i) {
-    if (i == height - 1) {
-      renderPoints.emplace_back(Y_THRESHOLD, i, '^');
-      continue;
-    } else if (i % ySteps == 0) {
-      renderPoints.emplace_back(Y_THRESHOLD, i, '+');
-      continue;
-    } else {
-      renderPoints.emplace_back(Y_THRESHOLD, i, '|');
-    }
+  surface.verticalSpan(Y_THRESHOLD, 0, height - 1, '|');
+  for (int i = 0; i < height; i += ySteps) {
+    surface.point(Y_THRESHOLD, i, '+');
   }
-
-  return renderPoints;
+  surface.point(Y_THRESHOLD, height - 1, '^');
 }
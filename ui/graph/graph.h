@@ -1,4 +1,7 @@
+#pragma once
+
 #include "../../core/candlestick.h"
+#include "../../core/decimation.h"
 #include "../../ui/menu/menu.h"
 #include "../renderer.h"
 
@@ -7,13 +10,28 @@ public:
   Graph(const vector<Candlestick> &_candlesticks, GraphParametersDTO *_graphParameters, vector<FilterDTO<string>> *_filters)
       : candlesticks(_candlesticks), graphParameters(_graphParameters), filters(_filters) {}
 
-  vector<RenderPoint> render(const Canvas &canvas) const override;
-  void setCandlesticks(const vector<Candlestick> &_candlesticks) { candlesticks = _candlesticks; }
+  void draw(Surface &surface) const override;
+  void setCandlesticks(const vector<Candlestick> &_candlesticks) {
+    candlesticks = _candlesticks;
+    ++version;
+  }
+  const vector<Candlestick> &getCandlesticks() const { return candlesticks; }
+  // Bumped by setCandlesticks, so overlays know when to recompute.
+  uint64_t getVersion() const { return version; }
 
 private:
   shared_ptr<GraphParametersDTO> graphParameters;
   shared_ptr<vector<FilterDTO<string>>> filters;
   vector<Candlestick> candlesticks;
-  vector<RenderPoint> renderAxes(const Canvas &canvas) const;
-  vector<RenderPoint> renderCandlesticks(const Canvas &canvas) const;
+  uint64_t version = 0;
+  // Scratch for renderOverview, kept so a redraw reuses its capacity.
+  mutable vector<Candlestick> decimated;
+  void renderAxes(Surface &surface) const;
+  void renderCandlesticks(Surface &surface) const;
+  void renderOverview(Surface &surface) const;
+  // Temperature labels on the y axis, one per y element.
+  void renderScale(Surface &surface, float min, float tempStep) const;
+  void renderCandlestick(Surface &surface, int x,
+                         const Candlestick &candlestick, float min,
+                         float diff) const;
 };
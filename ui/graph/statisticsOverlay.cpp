@@ -0,0 +1,101 @@
+#include "statisticsOverlay.h"
+#include <algorithm>
+#include <cmath>
+
+#define DEVIATION_BANDS 2
+
+static int toRow(float value, int height, float lowest, float diff) {
+  return floor((value - lowest) * height / diff);
+}
+
+void StatisticsOverlay::draw(Surface &surface) const {
+  const vector<Candlestick> &candlesticks = graph.getCandlesticks();
+  const u_int window = graphParameters->getRollingWindow();
+  // Overviews have no candlestick slots to line the statistics up with.
+  if (window == 0 || candlesticks.empty() ||
+      graphParameters->getDecimation() != DecimationMode::PAGED) {
+    return;
+  }
+
+  if (window != cachedWindow || graph.getVersion() != cachedVersion) {
+    update(window);
+  }
+
+  int width = surface.getWidth();
+  int height = surface.getHeight();
+  int xSteps = floor(width / graphParameters->getXElements());
+
+  // Same candlesticks and bounds as Graph::renderCandlesticks.
+  const size_t last =
+      min<size_t>(graphParameters->getXElements(), candlesticks.size());
+
+  float lowest;
+  float highest;
+  CandlestickProcessor::getBounds(candlesticks, 0, last, lowest, highest);
+  const float diff = highest - lowest;
+  if (!(diff > 0) || xSteps <= 0) {
+    return;
+  }
+
+  // The first window - 1 candlesticks have no full window behind them.
+  const size_t first = window - 1;
+
+  renderLine(surface, upperBand, first, last, xSteps, lowest, diff, '.');
+  renderLine(surface, lowerBand, first, last, xSteps, lowest, diff, '.');
+  renderLine(surface, means, first, last, xSteps, lowest, diff, '*');
+
+  // The graph leaves the last paginated candlestick out, so does the median.
+  for (size_t k = first; k + 1 < last; ++k) {
+    surface.point((k + 1) * xSteps + 1,
+                  toRow(medians[k], height, lowest, diff), 'o');
+  }
+}
+
+void StatisticsOverlay::update(u_int window) const {
+  const vector<Candlestick> &candlesticks = graph.getCandlesticks();
+
+  vector<float> closes;
+  closes.reserve(candlesticks.size());
+  for (const Candlestick &candlestick : candlesticks) {
+    closes.push_back(candlestick.close);
+  }
+
+  const vector<RollingSnapshot> snapshots =
+      RollingStatistics::compute(closes, window);
+
+  means.clear();
+  upperBand.clear();
+  lowerBand.clear();
+  medians.clear();
+  for (const RollingSnapshot &snapshot : snapshots) {
+    means.push_back(snapshot.mean);
+    upperBand.push_back(snapshot.mean + DEVIATION_BANDS * snapshot.deviation);
+    lowerBand.push_back(snapshot.mean - DEVIATION_BANDS * snapshot.deviation);
+    medians.push_back(snapshot.percentile);
+  }
+
+  cachedWindow = window;
+  cachedVersion = graph.getVersion();
+}
+
+void StatisticsOverlay::renderLine(Surface &surface, const vector<float> &line,
+                                   size_t first, size_t last, int xSteps,
+                                   float lowest, float diff,
+                                   char symbol) const {
+  const int width = surface.getWidth();
+  const int height = surface.getHeight();
+
+  // Value k sits on the column of candlestick k, x = (k + 1) * xSteps.
+  for (size_t k = first; k + 2 < last; ++k) {
+    for (int step = 0; step < xSteps; ++step) {
+      const int x = (k + 1) * xSteps + step;
+      if (x >= width) {
+        return;
+      }
+
+      const float value =
+          line[k] + (line[k + 1] - line[k]) * step / float(xSteps);
+      surface.point(x, toRow(value, height, lowest, diff), symbol);
+    }
+  }
+}
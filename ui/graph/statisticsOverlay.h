@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../../core/rollingStatistics.h"
+#include "../../ui/menu/menu.h"
+#include "../renderer.h"
+#include "graph.h"
+
+// Moving average, two deviation bands and the rolling median of the closes,
+// drawn on the scale of the candlesticks the graph shows. Render it before
+// the graph so the candlesticks and axes stay on top.
+//
+// The statistics are computed over the graph's whole series and kept until
+// its candlesticks or the window change; a drawn window starts with the
+// candlesticks before it, and windows without enough of them are skipped.
+class StatisticsOverlay : public IRenderable {
+public:
+  StatisticsOverlay(const Graph &_graph, GraphParametersDTO *_graphParameters)
+      : graph(_graph), graphParameters(_graphParameters), cachedVersion(0),
+        cachedWindow(0) {}
+
+  void draw(Surface &surface) const override;
+
+private:
+  const Graph &graph;
+  GraphParametersDTO *graphParameters;
+
+  // One value per candlestick of the graph.
+  mutable vector<float> means;
+  mutable vector<float> upperBand;
+  mutable vector<float> lowerBand;
+  mutable vector<float> medians;
+  mutable uint64_t cachedVersion;
+  mutable u_int cachedWindow;
+
+  void update(u_int window) const;
+  // Samples a line through the values of candlesticks [first, last), one
+  // per candlestick column, interpolated over the columns in between.
+  void renderLine(Surface &surface, const vector<float> &line, size_t first,
+                  size_t last, int xSteps, float lowest, float diff,
+                  char symbol) const;
+};
@@ -61,65 +61,106 @@ void Menu::setParser(TemperatureMenuDataTransfer &_parser) {
 const TemperatureMenuDataTransfer &Menu::getParser() { return *this->parser; }
 
 void Menu::requestChoice() {
-  char input[3];
+  char input[3] = {0, 0, 0};
 
-  read(STDIN_FILENO, input, 3);
+  // With a read timeout set the read can return empty-handed.
+  const ssize_t size = read(STDIN_FILENO, input, 3);
+  if (size <= 0) {
+    return;
+  }
 
-  const unsigned int optionsLength = this->state->getOptions().size();
+  handleKeys(string(input, size));
+}
 
-  if (input[0] == ESCAPE) {
-    if (input[1] == ARROW) {
-      switch (input[2]) {
-      case UP:
-        this->setChoice((this->currentChoice - 1) % optionsLength);
-        break;
-      case DOWN:
-        this->setChoice((this->currentChoice + 1) % optionsLength);
+// Arrow keys arrive as three bytes, ESC [ and the direction, and a read
+// can end between them.
+bool Menu::handleKeys(const string &burst) {
+  const string keys = pendingEscape + burst;
+  pendingEscape.clear();
+  bool handled = false;
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i] == ESCAPE) {
+      if (i + 1 == keys.size() ||
+          (i + 2 == keys.size() && keys[i + 1] == ARROW)) {
+        pendingEscape = keys.substr(i);
         break;
       }
+
+      if (keys[i + 1] == ARROW) {
+        handled = handleArrow(keys[i + 2]) || handled;
+        i += 2;
+      }
+      continue;
     }
+
+    handled = handleKey(keys[i]) || handled;
   }
 
-  if (input[0] != ESCAPE) {
-    switch (input[0]) {
-    case 'I':
-      this->options->setOptions(new bool(!this->options->getShowControls()),
-                                nullptr);
-      break;
-    case 'G':
-      this->coreEvents->graph = !this->coreEvents->graph;
-      break;
-    case 'F':
-      this->options->setOptions(nullptr,
-                                new bool(!this->options->getShowFilters()));
-      break;
-    case 'j':
-      this->setChoice((this->currentChoice + 1) % optionsLength);
-      break;
-    case 'k':
-      this->setChoice((this->currentChoice - 1) % optionsLength);
-      break;
-    case 'q':
-      cout << "Quitting..." << endl;
-      exit(0);
-      break;
-    case ' ':
-      this->state->handleChoice(*this, this->currentChoice);
-      break;
-    }
+  return handled;
+}
+
+bool Menu::handleArrow(char direction) {
+  const unsigned int optionsLength = this->state->getOptions().size();
+
+  switch (direction) {
+  case UP:
+    this->setChoice((this->currentChoice - 1) % optionsLength);
+    return true;
+  case DOWN:
+    this->setChoice((this->currentChoice + 1) % optionsLength);
+    return true;
+  }
+
+  return false;
+}
+
+bool Menu::handleKey(char key) {
+  const unsigned int optionsLength = this->state->getOptions().size();
+
+  switch (key) {
+  case 'I':
+    this->options->setOptions(new bool(!this->options->getShowControls()),
+                              nullptr);
+    return true;
+  case 'G':
+    this->coreEvents->graph = !this->coreEvents->graph;
+    return true;
+  case 'F':
+    this->options->setOptions(nullptr,
+                              new bool(!this->options->getShowFilters()));
+    return true;
+  case 'j':
+    this->setChoice((this->currentChoice + 1) % optionsLength);
+    return true;
+  case 'k':
+    this->setChoice((this->currentChoice - 1) % optionsLength);
+    return true;
+  case 'q':
+    cout << "Quitting..." << endl;
+    exit(0);
+  case ' ':
+    this->state->handleChoice(*this, this->currentChoice);
+    return true;
   }
+
+  return false;
 }
 
 const unordered_map<FilterType, string> filtersMap = {
-    {FilterType::location, "Location"}, {FilterType::timeRange, "Time range"}};
+    {FilterType::location, "Location"},
+    {FilterType::timeRange, "Time range"},
+    {FilterType::temperatureRange, "Temperature range"}};
 
 void Menu::run() {
-  this->state->render(*this);
+  this->render();
   this->requestChoice();
 
   return;
 }
 
+void Menu::render() { this->state->render(*this); }
+
 void Menu::handleChoice() {
   this->state->handleChoice(*this, this->currentChoice);
 }
@@ -163,6 +204,8 @@ TemperatureMenuDataTransfer::TemperatureMenuDataTransfer(
             FilterDTO<string>(
                 LocationEnumProcessor::locationToString(EULocation::de),
                 FilterType::location),
+            FilterDTO<string>(DEFAULT_TEMPERATURE_RANGE,
+                              FilterType::temperatureRange),
         }));
   }
 }
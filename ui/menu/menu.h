@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../../core/calendarBuckets.h"
+#include "../../core/decimation.h"
 #include "states/menuState.h"
 
 #include <memory>
@@ -20,8 +22,14 @@ public:
 
 class GraphParametersDTO {
 public:
-  GraphParametersDTO(u_int _xElements, u_int _yElements)
-      : xElements(_xElements), yElements(_yElements) {};
+  GraphParametersDTO(u_int _xElements, u_int _yElements,
+                     u_int _hoursStep = 24 * 31,
+                     BucketUnit _bucketUnit = BucketUnit::MONTH,
+                     u_int _rollingWindow = 3,
+                     DecimationMode _decimation = DecimationMode::PAGED)
+      : xElements(_xElements), yElements(_yElements), hoursStep(_hoursStep),
+        bucketUnit(_bucketUnit), rollingWindow(_rollingWindow),
+        decimation(_decimation) {};
 
   u_int getXElements() { return xElements; }
   void setXElements(u_int _xElements) { xElements = _xElements; }
@@ -29,12 +37,46 @@ public:
   u_int getYElements() { return yElements; }
   void setYElements(u_int _yElements) { yElements = _yElements; }
 
+  // Hourly rows per candlestick, used when the bucket unit is HOURS.
+  u_int getHoursStep() { return hoursStep; }
+  void setHoursStep(u_int _hoursStep) { hoursStep = _hoursStep; }
+
+  BucketUnit getBucketUnit() { return bucketUnit; }
+  void setBucketUnit(BucketUnit _bucketUnit) { bucketUnit = _bucketUnit; }
+
+  // Candlesticks per rolling statistics window, 0 hides the overlay.
+  u_int getRollingWindow() { return rollingWindow; }
+  void setRollingWindow(u_int _rollingWindow) {
+    rollingWindow = _rollingWindow;
+  }
+
+  DecimationMode getDecimation() { return decimation; }
+  void setDecimation(DecimationMode _decimation) { decimation = _decimation; }
+
+  bool operator==(const GraphParametersDTO &other) const {
+    return xElements == other.xElements && yElements == other.yElements &&
+           hoursStep == other.hoursStep && bucketUnit == other.bucketUnit &&
+           rollingWindow == other.rollingWindow &&
+           decimation == other.decimation;
+  }
+  bool operator!=(const GraphParametersDTO &other) const {
+    return !(*this == other);
+  }
+
 private:
   u_int xElements;
   u_int yElements;
+  u_int hoursStep;
+  BucketUnit bucketUnit;
+  u_int rollingWindow;
+  DecimationMode decimation;
 };
 
-enum FilterType { timeRange, location };
+// Wide enough to keep every reading, as MIN|MAX in degrees Celsius.
+#define DEFAULT_TEMPERATURE_RANGE "-100|100"
+
+// Filters are listed in the menu in this order.
+enum FilterType { timeRange, location, temperatureRange };
 
 extern const unordered_map<FilterType, string> filtersMap;
 
@@ -43,6 +85,10 @@ public:
   FilterDTO(T _value, FilterType _type) : value(_value), type(_type) {};
   T value;
   FilterType type;
+
+  bool operator==(const FilterDTO &other) const {
+    return value == other.value && type == other.type;
+  }
 };
 
 class TemperatureMenuDataTransfer {
@@ -93,8 +139,13 @@ public:
   void handleChoice();
   void handleInput();
 
+  // Blocks for one key and handles it.
   void requestChoice();
   void reqeustInput();
+  // Handles every key of a burst read elsewhere, false if none did
+  // anything. An escape sequence cut off at the end of the burst is kept
+  // and completed by the next one.
+  bool handleKeys(const string &burst);
 
   void setCoreEvents(bool showGraph);
   const ExternalCoreEvents &getCoreEvents();
@@ -106,6 +157,7 @@ public:
   const MenuOptions &getOptions();
 
   void run();
+  void render();
 
 private:
   Menu(const TemperatureMenuDataTransfer &_parser, const MenuOptions &_options);
@@ -119,4 +171,9 @@ private:
   unique_ptr<ExternalCoreEvents> coreEvents;
   unique_ptr<MenuOptions> options;
   shared_ptr<TemperatureMenuDataTransfer> parser;
+  // Start of an arrow key sequence the last burst ended in.
+  string pendingEscape;
+
+  bool handleKey(char key);
+  bool handleArrow(char direction);
 };
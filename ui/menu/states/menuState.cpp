@@ -1,9 +1,12 @@
 #include "menuState.h"
+#include "../../../core/candlestick.h"
 #include "../../../core/temperaturePoint.h"
+#include "../../../utils/dateTime.h"
 #include "../../../utils/logger.h"
 #include "../../../utils/terminalTextStyles.h"
 #include "../menu.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <termios.h>
@@ -13,6 +16,7 @@
 using namespace terminalTextStyles;
 
 MenuMode MenuModeManager::mode = MenuMode::input;
+unsigned char MenuModeManager::readTimeout = 0;
 struct termios MenuModeManager::oldt, MenuModeManager::newt;
 
 void MenuModeManager::controlMode() {
@@ -24,6 +28,8 @@ void MenuModeManager::controlMode() {
   tcgetattr(STDIN_FILENO, &oldt);
   newt = oldt;
   newt.c_lflag &= ~(ICANON | ECHO);
+  newt.c_cc[VMIN] = readTimeout == 0 ? 1 : 0;
+  newt.c_cc[VTIME] = readTimeout;
   tcsetattr(STDIN_FILENO, TCSANOW, &newt);
 
   mode = MenuMode::control;
@@ -162,7 +168,11 @@ GraphSettingsMenu::GraphSettingsMenu() {
   title = "Graph Settings Menu\nSelect the graph setting you want "
           "to change";
   options = {"1. Change amount of element on X axis",
-             "2. Change amount of element on Y axis", "3. Back"};
+             "2. Change amount of element on Y axis",
+             "3. Change hours per candlestick",
+             "4. Change calendar period per candlestick",
+             "5. Change rolling statistics window",
+             "6. Change overview mode", "7. Back"};
   MenuModeManager::controlMode();
 }
 
@@ -197,6 +207,16 @@ void GraphSettingsMenu::displayGraphSettings(Menu &menu) {
   cout << "Graph settings" << endl;
   cout << "Amount of X axis elements: " << parameters.getXElements() << endl;
   cout << "Amount of Y axis elements: " << parameters.getYElements() << endl;
+  if (parameters.getBucketUnit() == BucketUnit::HOURS) {
+    cout << "Hours per candlestick: " << parameters.getHoursStep() << endl;
+  } else {
+    cout << "Candlestick period: "
+         << CalendarBuckets::unitToString(parameters.getBucketUnit()) << endl;
+  }
+  cout << "Rolling statistics window: " << parameters.getRollingWindow()
+       << endl;
+  cout << "Overview mode: "
+       << Decimation::modeToString(parameters.getDecimation()) << endl;
 
   return;
 }
@@ -217,6 +237,36 @@ void GraphSettingsMenu::handleChoice(Menu &menu,
     handleInput(yElements);
     parameters.setYElements(yElements);
   } else if (optionIndex + 1 == 3) {
+    cout << "Enter the amount of hours per candlestick" << endl;
+    u_int hoursStep = parameters.getHoursStep();
+    handleInput(hoursStep);
+    parameters.setHoursStep(max(1u, hoursStep));
+    parameters.setBucketUnit(BucketUnit::HOURS);
+  } else if (optionIndex + 1 == 4) {
+    cout << "Enter 1 for days, 2 for weeks, 3 for months or 4 for years"
+         << endl;
+    u_int period = static_cast<u_int>(parameters.getBucketUnit());
+    handleInput(period);
+    if (period >= 1 && period <= 4) {
+      parameters.setBucketUnit(static_cast<BucketUnit>(period));
+    }
+  } else if (optionIndex + 1 == 5) {
+    cout << "Enter the amount of candlesticks per rolling window, 0 hides "
+            "the overlay"
+         << endl;
+    u_int rollingWindow = parameters.getRollingWindow();
+    handleInput(rollingWindow);
+    parameters.setRollingWindow(rollingWindow);
+  } else if (optionIndex + 1 == 6) {
+    cout << "Enter 0 to page through the candlesticks, 1 for a min/max "
+            "overview or 2 for an LTTB overview"
+         << endl;
+    u_int mode = static_cast<u_int>(parameters.getDecimation());
+    handleInput(mode);
+    if (mode <= 2) {
+      parameters.setDecimation(static_cast<DecimationMode>(mode));
+    }
+  } else if (optionIndex + 1 == 7) {
     menu.changeState(new GraphMenu());
   } else {
     cout << "Invalid choice! Please select a number between 1 and "
@@ -347,9 +397,13 @@ void FilterMenu::render(Menu &menu) {
 vector<string> FilterMenu::generateFilters() {
   vector<string> options{};
 
+  // One option per FilterType in enum order, handleChoice maps the option
+  // index back to the type.
   unsigned int i = 1;
-  for (const pair<FilterType, string> &filterPair : filtersMap) {
-    options.emplace_back(to_string(i) + ". " + filterPair.second);
+  for (int type = FilterType::timeRange; type <= FilterType::temperatureRange;
+       ++type) {
+    options.emplace_back(to_string(i) + ". " +
+                         filtersMap.at(FilterType(type)));
     ++i;
   }
 
@@ -378,6 +432,38 @@ void FilterMenu::handleDateInput(string &value) {
     return;
   }
 
+  // Both dates must parse, otherwise compiling the filter would throw.
+  int64_t start = 0;
+  int64_t end = 0;
+  if (!DateTimeProcessor::parseIso(input.data(), ISO_STRING_LENGTH, start) ||
+      !DateTimeProcessor::parseIso(input.data() + ISO_STRING_LENGTH + 1,
+                                   ISO_STRING_LENGTH, end)) {
+    cout << "Invalid date! Please enter a date in the format." << endl;
+    return;
+  }
+
+  value = input;
+
+  return;
+}
+
+void FilterMenu::handleTemperatureInput(string &value) {
+  cout << "Enter the temperature range in degrees Celsius as MIN|MAX, e.g. "
+       << DEFAULT_TEMPERATURE_RANGE << endl;
+  string input;
+  MenuModeManager::inputMode();
+  cin >> input;
+
+  try {
+    CandlestickFilter::compile(
+        {FilterDTO<string>(input, FilterType::temperatureRange)});
+  } catch (const invalid_argument &) {
+    cout << "Invalid temperature range! Enter two numbers as MIN|MAX with "
+            "MIN not above MAX."
+         << endl;
+    return;
+  }
+
   value = input;
 
   return;
@@ -390,26 +476,47 @@ void FilterMenu::handleChoice(Menu &menu, const unsigned int &optionIndex) {
     return;
   }
 
+  if (options.size() == optionIndex + 1) {
+    menu.changeState(new GraphMenu());
+    return;
+  }
+
   TemperatureMenuDataTransfer parser = menu.getParser();
   vector<FilterDTO<string>> filters = parser.getFilters();
 
-  if (filters[optionIndex].type == FilterType::location) {
-    menu.changeState(new CountrySelectionMenu());
+  const FilterType type = FilterType(optionIndex);
+  const auto selected =
+      find_if(filters.begin(), filters.end(),
+              [type](const FilterDTO<string> &filter) {
+                return filter.type == type;
+              });
+
+  if (selected == filters.end()) {
     return;
   }
 
-  if (options.size() == optionIndex + 1) {
-    menu.changeState(new GraphMenu());
+  if (type == FilterType::location) {
+    menu.changeState(new CountrySelectionMenu());
     return;
   }
 
   string value;
-  handleDateInput(value);
+  if (type == FilterType::temperatureRange) {
+    handleTemperatureInput(value);
+  } else {
+    handleDateInput(value);
+  }
 
   MenuModeManager::controlMode();
 
+  // An invalid input leaves the filter as it was.
+  if (value.empty()) {
+    menu.changeState(new FilterMenu());
+    return;
+  }
+
   for (FilterDTO<string> &filter : filters) {
-    if (filter.type == FilterType::timeRange) {
+    if (filter.type == type) {
       filter.value = value;
     }
   }
@@ -12,6 +12,8 @@ enum MenuMode { control, input };
 class MenuModeManager {
 public:
   static MenuMode mode;
+  // Deciseconds a control-mode read waits for a key, 0 blocks until one.
+  static unsigned char readTimeout;
   static void controlMode();
   static void inputMode();
 
@@ -86,6 +88,7 @@ public:
 private:
   void printControlsHelp() override;
   void handleDateInput(string &value);
+  void handleTemperatureInput(string &value);
   vector<string> generateFilters();
 };
 
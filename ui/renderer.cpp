@@ -1,87 +1,249 @@
 #include "renderer.h"
-#include "../utils/logger.h"
-#include <cmath>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <iostream>
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <vector>
 
+// Unchanged cells up to this many are sent again rather than jumped over,
+// a cursor move costs about as much.
+#define RUN_GAP 6
+
+// Used when stdout is not a terminal.
+#define DEFAULT_COLUMNS 80
+#define DEFAULT_ROWS 24
+
+// The menu never takes more than half of the terminal.
+static int graphRows(int terminalHeight) {
+  return terminalHeight - min(MENU_ROWS, terminalHeight / 2);
+}
+
 Canvas::Canvas() {
-  struct winsize w;
-  ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
+  readSize();
+  cells.assign(width * height, ' ');
+}
+
+void Canvas::readSize() {
+  struct winsize w {};
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) < 0 || w.ws_col == 0 ||
+      w.ws_row == 0) {
+    w.ws_col = DEFAULT_COLUMNS;
+    w.ws_row = DEFAULT_ROWS;
+  }
+
   width = w.ws_col;
-  height = floor(w.ws_row);
-  grid = vector<vector<char>>(height, vector<char>(width, ' '));
+  terminalHeight = w.ws_row;
+  height = graphRows(terminalHeight);
 }
 
-void Canvas::resize() {
-  struct winsize w;
-  ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
-  this->width = w.ws_col;
-  this->height = floor(w.ws_row);
-  this->grid = vector<vector<char>>(height, vector<char>(width, ' '));
+bool Canvas::resize() {
+  const int previousWidth = width;
+  const int previousHeight = terminalHeight;
+  readSize();
+
+  if (width == previousWidth && terminalHeight == previousHeight) {
+    return false;
+  }
+
+  cells.assign(width * height, ' ');
+  return true;
 }
 
-vector<RenderPoint> IRenderable::render(const Canvas &canvas) const {
-  return vector<RenderPoint>{};
+void Canvas::set(int x, int y, char symbol) {
+  if (x >= 0 && x < width && y >= 0 && y < height) {
+    cells[y * width + x] = symbol;
+  }
 }
 
-void Renderer::clearCanvas() {
-  vector<vector<char>> &grid = this->canvas.getGrid();
+void Canvas::clear() { fill(cells.begin(), cells.end(), ' '); }
 
-  for (int i = 0; i < grid.size(); ++i) {
-    for (int j = 0; j < grid[i].size(); ++j) {
-      grid[i][j] = ' ';
-    }
+void Surface::verticalSpan(int x, int fromY, int toY, char symbol) {
+  if (x < 0 || x >= canvas.getWidth()) {
+    return;
+  }
+
+  for (int y = max(0, fromY); y < min(toY, canvas.getHeight()); ++y) {
+    canvas.getRow(y)[x] = symbol;
+  }
+}
+
+void Surface::horizontalLine(int fromX, int toX, int y, char symbol) {
+  if (y < 0 || y >= canvas.getHeight()) {
+    return;
   }
 
+  fromX = max(0, fromX);
+  toX = min(toX, canvas.getWidth());
+  if (fromX < toX) {
+    fill(canvas.getRow(y) + fromX, canvas.getRow(y) + toX, symbol);
+  }
+}
+
+void Surface::text(int x, int y, const char *characters, size_t length) {
+  if (y < 0 || y >= canvas.getHeight()) {
+    return;
+  }
+
+  const int begin = max(0, x);
+  const int end = min(canvas.getWidth(), x + static_cast<int>(length));
+  if (begin < end) {
+    copy(characters + (begin - x), characters + (end - x),
+         canvas.getRow(y) + begin);
+  }
+}
+
+void IRenderable::draw(Surface &surface) const {
+  for (const RenderPoint &point : render(surface.getCanvas())) {
+    surface.point(point.x, point.y, point.symbol);
+  }
+}
+
+vector<RenderPoint> IRenderable::render(const Canvas &) const {
+  return vector<RenderPoint>{};
+}
+
+void Renderer::clearCanvas() { this->canvas.clear(); }
+
+// The terminal may have reflowed what it showed even at the same size.
+void Renderer::resize() {
   this->canvas.resize();
+  invalidate();
 }
 
-void Renderer::render(const vector<IRenderable *> &renderables) {
+void Renderer::clearMenu() {
+  output.clear();
+  appendCursor(canvas.getHeight() + 1, 1);
+  output += "\x1B[J";
+
+  cout.flush();
+  writeOutput();
+}
 
-  vector<RenderPoint> renderPoints{};
+void Renderer::render(const vector<IRenderable *> &renderables) {
+  Surface surface{canvas};
 
-  for (int i = 0; i < renderables.size(); ++i) {
+  for (size_t i = 0; i < renderables.size(); ++i) {
     auto *it = renderables[i];
     if (it == nullptr) {
       continue;
     }
 
-    vector<RenderPoint> addPoints = it->render(canvas);
-
-    renderPoints.insert(renderPoints.end(), addPoints.begin(), addPoints.end());
+    it->draw(surface);
   }
 
-  const vector<vector<char>> &grid = modifyGrid(renderPoints);
+  const int width = canvas.getWidth();
+  const int height = canvas.getHeight();
+  const vector<char> &cells = canvas.getCells();
+
+  // Canvas row i is terminal line height - i, the first row is the bottom.
+  output.clear();
+  if (front.size() != cells.size() || frontWidth != width) {
+    output += "\x1B[r\x1B[2J";
+    for (int i = 0; i < height; ++i) {
+      appendCursor(height - i, 1);
+      output.append(canvas.getRow(i), width);
+    }
 
-  for (int i = grid.size() - 1; i >= 0; --i) {
-    for (int j = 0; j < grid[i].size(); ++j) {
-      cout << grid[i][j];
+    // Menu output scrolls below the graph instead of pushing it up.
+    output += "\x1B[";
+    appendNumber(height + 1);
+    output += ';';
+    appendNumber(canvas.getTerminalHeight());
+    output += 'r';
+  } else {
+    for (int i = 0; i < height; ++i) {
+      appendChanges(canvas.getRow(i), front.data() + i * width, height - i);
     }
-    cout << endl;
   }
 
+  appendCursor(height + 1, 1);
+  output += "\x1B[J";
+
+  cout.flush();
+  writeOutput();
+  front.assign(cells.begin(), cells.end());
+  frontWidth = width;
+
   return;
 }
 
-Renderer::Renderer(Canvas _canvas) { canvas = _canvas; }
+// Leaves the cursor on the last line with the whole terminal scrolling
+// again, for whatever runs after the program.
+static void resetScrollRegion() {
+  const char reset[] = "\x1B[r\x1B[999;1H";
+  cout.flush();
+  if (write(STDOUT_FILENO, reset, sizeof(reset) - 1) < 0) {
+    return;
+  }
+}
 
-vector<vector<char>>
-Renderer::modifyGrid(const vector<RenderPoint> &renderPoints) {
-  vector<vector<char>> &grid = this->canvas.getGrid();
+Renderer::Renderer(Canvas _canvas) : canvas(_canvas), frontWidth(0) {
+  atexit(resetScrollRegion);
+}
 
-  auto *logger = Logger::getInstance(EnvType::PROD);
+void Renderer::appendCursor(int line, int column) {
+  output += "\x1B[";
+  appendNumber(line);
+  output += ';';
+  appendNumber(column);
+  output += 'H';
+}
 
-  for (int i = 0; i < renderPoints.size(); ++i) {
-    const int &x = renderPoints[i].x;
-    const int &y = renderPoints[i].y;
-    const char &symbol = renderPoints[i].symbol;
+// to_string would build a temporary string per escape code.
+void Renderer::appendNumber(int value) {
+  char digits[12];
+  int size = 0;
+  do {
+    digits[size++] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0);
+
+  while (size > 0) {
+    output += digits[--size];
+  }
+}
 
-    if ((y >= 0 && y < grid.size()) && (x >= 0 && x < grid[y].size())) {
-      grid[y][x] = symbol;
+// Each run starts at a changed cell and ends at the last changed cell
+// before a gap longer than RUN_GAP.
+void Renderer::appendChanges(const char *row, const char *previous,
+                             int line) {
+  const int width = canvas.getWidth();
+  int column = 0;
+  while (column < width) {
+    if (row[column] == previous[column]) {
+      ++column;
+      continue;
     }
+
+    int last = column;
+    for (int i = column + 1; i < width && i - last <= RUN_GAP; ++i) {
+      if (row[i] != previous[i]) {
+        last = i;
+      }
+    }
+
+    appendCursor(line, column + 1);
+    output.append(row + column, last + 1 - column);
+    column = last + 1;
   }
+}
+
+// One write per frame, repeated only if the terminal takes part of it.
+void Renderer::writeOutput() {
+  size_t written = 0;
+  while (written < output.size()) {
+    const ssize_t result = write(STDOUT_FILENO, output.data() + written,
+                                 output.size() - written);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
 
-  return grid;
+    if (result <= 0) {
+      return;
+    }
+
+    written += result;
+  }
 }
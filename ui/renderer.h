@@ -1,7 +1,13 @@
+#pragma once
+
+#include <string>
 #include <vector>
 
 using namespace std;
 
+// Terminal rows kept under the graph for the menu, which scrolls inside them.
+#define MENU_ROWS 16
+
 class RenderPoint {
 public:
   int x;
@@ -10,35 +16,91 @@ public:
   RenderPoint(int _x, int _y, char _symbol) : x(_x), y(_y), symbol(_symbol) {}
 };
 
+// One flat buffer of cells, row y = 0 being the bottom line. It is only
+// reallocated when the terminal size changes.
 class Canvas {
 public:
   Canvas();
-  vector<vector<char>> &getGrid() { return this->grid; }
+  char *getRow(int y) { return cells.data() + y * width; }
+  const char *getRow(int y) const { return cells.data() + y * width; }
+  const vector<char> &getCells() const { return cells; }
+  // Cells outside the canvas are ignored.
+  void set(int x, int y, char symbol);
+  void clear();
   int getWidth() const { return width; }
   int getHeight() const { return height; }
-  void resize();
+  int getTerminalHeight() const { return terminalHeight; }
+  // Re-reads the terminal size, true if it changed.
+  bool resize();
 
 private:
   int width;
   int height;
-  vector<vector<char>> grid;
+  int terminalHeight;
+  vector<char> cells;
+
+  void readSize();
+};
+
+// Drawing primitives writing straight into the canvas cells, clipped to
+// the canvas. Spans and lines cover [from, to).
+class Surface {
+public:
+  Surface(Canvas &_canvas) : canvas(_canvas) {}
+
+  const Canvas &getCanvas() const { return canvas; }
+  int getWidth() const { return canvas.getWidth(); }
+  int getHeight() const { return canvas.getHeight(); }
+
+  void point(int x, int y, char symbol) { canvas.set(x, y, symbol); }
+  void verticalSpan(int x, int fromY, int toY, char symbol);
+  void horizontalLine(int fromX, int toX, int y, char symbol);
+  void text(int x, int y, const char *characters, size_t length);
+  void text(int x, int y, const string &characters) {
+    text(x, y, characters.data(), characters.size());
+  }
+
+private:
+  Canvas &canvas;
 };
 
 class IRenderable {
 public:
-  virtual vector<RenderPoint> render(const Canvas &canvas) const = 0;
+  // Renderables override draw. The default plots the points of render, the
+  // older interface, which is kept only for compatibility.
+  virtual void draw(Surface &surface) const;
+  virtual vector<RenderPoint> render(const Canvas &canvas) const;
   virtual ~IRenderable() = default;
 };
 
+// Draws frames by diffing them against the previous one: only the changed
+// runs of cells are sent, each after a cursor move, in a single write. The
+// graph keeps the top rows of the terminal and the menu scrolls in the rows
+// below it, so the previous frame stays where it was drawn. Its buffers are
+// reused, so a frame of the same size allocates nothing here.
 class Renderer {
 public:
   Renderer(Canvas _canvas);
   void render(const vector<IRenderable*> &renderables);
   const Canvas &getCanvas() const { return canvas; }
   void clearCanvas();
+  // Follows a terminal resize, the next frame is drawn in full.
+  void resize();
+  // Empties the menu rows and leaves the cursor at their top.
+  void clearMenu();
+  // The next frame is drawn in full, for when something else wrote over it.
+  void invalidate() { front.clear(); }
 
 private:
-  vector<IRenderable> renderables;
   Canvas canvas;
-  vector<vector<char>> modifyGrid(const vector<RenderPoint> &renderPoints);
+  // What the terminal shows, laid out like the canvas cells.
+  vector<char> front;
+  int frontWidth;
+  // Escape codes and cells of one frame.
+  string output;
+
+  void appendChanges(const char *row, const char *previous, int line);
+  void appendCursor(int line, int column);
+  void appendNumber(int value);
+  void writeOutput();
 };
@@ -0,0 +1,77 @@
+#include "dateTime.h"
+#include "fieldParser.h"
+#include <cstdio>
+#include <stdexcept>
+
+bool DateTimeProcessor::parseIso(const char *text, size_t length,
+                                 int64_t &epoch) {
+  return FieldParser::parseTimestamp(text, text + length, epoch);
+}
+
+int64_t DateTimeProcessor::parseIso(const string &text) {
+  int64_t epoch = 0;
+
+  if (!parseIso(text.data(), text.size(), epoch)) {
+    throw invalid_argument("Invalid date format: " + text);
+  }
+
+  return epoch;
+}
+
+string DateTimeProcessor::toIsoString(int64_t epoch) {
+  char buffer[ISO_STRING_LENGTH + 1];
+  formatIso(epoch, buffer);
+
+  return string(buffer, ISO_STRING_LENGTH);
+}
+
+void DateTimeProcessor::formatIso(int64_t epoch, char *buffer) {
+  int64_t days = epoch / SECONDS_IN_DAY;
+  int64_t seconds = epoch % SECONDS_IN_DAY;
+
+  if (seconds < 0) {
+    seconds += SECONDS_IN_DAY;
+    --days;
+  }
+
+  int64_t year;
+  unsigned month, day;
+  civilFromDays(days, year, month, day);
+
+  snprintf(buffer, ISO_STRING_LENGTH + 1, "%04lld-%02u-%02uT%02d:%02d:%02dZ",
+           static_cast<long long>(year), month, day,
+           static_cast<int>(seconds / SECONDS_IN_HOUR),
+           static_cast<int>(seconds % SECONDS_IN_HOUR / 60),
+           static_cast<int>(seconds % 60));
+}
+
+// Howard Hinnant's days_from_civil / civil_from_days, proleptic Gregorian.
+int64_t DateTimeProcessor::daysFromCivil(int64_t year, unsigned month,
+                                         unsigned day) {
+  year -= month <= 2;
+  const int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+  const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 +
+                             day - 1;
+  const unsigned dayOfEra =
+      yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+  return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+}
+
+void DateTimeProcessor::civilFromDays(int64_t days, int64_t &year,
+                                      unsigned &month, unsigned &day) {
+  days += 719468;
+  const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+  const unsigned yearOfEra =
+      (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) /
+      365;
+  const unsigned dayOfYear =
+      dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+
+  day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+  month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+  year = static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2);
+}
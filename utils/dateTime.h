@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+#define SECONDS_IN_HOUR 3600
+#define SECONDS_IN_DAY 86400
+#define ISO_STRING_LENGTH 20
+
+// Conversions between the dataset's fixed-width ISO 8601 timestamps
+// ("YYYY-MM-DDTHH:MM:SSZ") and UTC epoch seconds.
+class DateTimeProcessor {
+public:
+  static bool parseIso(const char *text, size_t length, int64_t &epoch);
+  static int64_t parseIso(const string &text);
+  static string toIsoString(int64_t epoch);
+  // Writes ISO_STRING_LENGTH characters and a terminating NUL to buffer.
+  static void formatIso(int64_t epoch, char *buffer);
+
+  static int64_t daysFromCivil(int64_t year, unsigned month, unsigned day);
+  static void civilFromDays(int64_t days, int64_t &year, unsigned &month,
+                            unsigned &day);
+};
@@ -0,0 +1,208 @@
+#include "fieldParser.h"
+#include "dateTime.h"
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Exactly representable powers of ten. With a mantissa below 2^24 both
+// operands of the division are exact, so IEEE division returns the
+// correctly rounded value, which is what strtof returns (Clinger's fast path).
+static const float POWERS_OF_TEN[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                                      1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+static const uint32_t MAX_EXACT_MANTISSA = 1u << 24;
+
+bool FieldParser::parseFloat(const char *begin, const char *end,
+                             const char *limit, float &value) {
+  if (begin >= end) {
+    return false;
+  }
+
+  const char *cursor = begin;
+  bool negative = *cursor == '-';
+  if (*cursor == '-' || *cursor == '+') {
+    ++cursor;
+  }
+
+  const size_t length = end - cursor;
+  if (length == 0) {
+    return false;
+  }
+
+  size_t dot = length;
+
+#ifdef __SSE2__
+  if (length <= 16 && limit - cursor >= 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(cursor));
+    const __m128i digits = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+    const __m128i isDigit = _mm_cmpeq_epi8(
+        _mm_max_epu8(digits, _mm_set1_epi8(9)), _mm_set1_epi8(9));
+    const __m128i isDot = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('.'));
+
+    const unsigned fieldMask = (1u << length) - 1;
+    const unsigned digitMask = _mm_movemask_epi8(isDigit) & fieldMask;
+    const unsigned dotMask = _mm_movemask_epi8(isDot) & fieldMask;
+
+    // Anything but digits and a single dot goes the slow way.
+    if ((digitMask | dotMask) != fieldMask || (dotMask & (dotMask - 1)) != 0 ||
+        digitMask == 0) {
+      return parseFloatFallback(begin, end, value);
+    }
+
+    if (dotMask != 0) {
+      dot = __builtin_ctz(dotMask);
+    }
+  } else
+#endif
+  {
+    bool seenDigit = false;
+    for (size_t i = 0; i < length; ++i) {
+      const unsigned digit = static_cast<unsigned char>(cursor[i]) - '0';
+      if (digit <= 9) {
+        seenDigit = true;
+      } else if (cursor[i] == '.' && dot == length) {
+        dot = i;
+      } else {
+        return parseFloatFallback(begin, end, value);
+      }
+    }
+
+    if (!seenDigit) {
+      return false;
+    }
+  }
+
+  const size_t fractionDigits = dot == length ? 0 : length - dot - 1;
+
+  uint64_t mantissa = 0;
+  for (size_t i = 0; i < length; ++i) {
+    if (i == dot) {
+      continue;
+    }
+    mantissa = mantissa * 10 + (cursor[i] - '0');
+    if (mantissa > MAX_EXACT_MANTISSA) {
+      return parseFloatFallback(begin, end, value);
+    }
+  }
+
+#if FLT_EVAL_METHOD == 0
+  if (fractionDigits < sizeof(POWERS_OF_TEN) / sizeof(POWERS_OF_TEN[0])) {
+    value = static_cast<float>(mantissa) / POWERS_OF_TEN[fractionDigits];
+    if (negative) {
+      value = -value;
+    }
+    return true;
+  }
+#endif
+
+  return parseFloatFallback(begin, end, value);
+}
+
+bool FieldParser::parseFloatFallback(const char *begin, const char *end,
+                                     float &value) {
+  // strtof needs a terminated string, the field is staged on the stack.
+  char buffer[64];
+  size_t length = end - begin;
+  if (length == 0 || length >= sizeof(buffer)) {
+    return false;
+  }
+
+  memcpy(buffer, begin, length);
+  buffer[length] = '\0';
+
+  char *parsed = nullptr;
+  value = strtof(buffer, &parsed);
+
+  return parsed == buffer + length;
+}
+
+bool FieldParser::parseTimestamp(const char *begin, const char *end,
+                                 int64_t &epoch) {
+  const size_t length = end - begin;
+  if (length < 19 || (length > 19 && begin[19] != 'Z')) {
+    return false;
+  }
+
+  unsigned year, month, day, hour, minute, second;
+
+#ifdef __SSE2__
+  // Bytes 0..15 hold "YYYY-MM-DDTHH:MM", validated and converted at once.
+  const __m128i bytes =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+  const __m128i separators =
+      _mm_setr_epi8(0, 0, 0, 0, '-', 0, 0, '-', 0, 0, 'T', 0, 0, ':', 0, 0);
+  const unsigned digitBits = 0xdb6f; // positions 0-3, 5-6, 8-9, 11-12, 14-15
+  const unsigned separatorBits = 0x2490; // positions 4, 7, 10, 13
+
+  const __m128i digits = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+  const unsigned digitMask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_max_epu8(digits, _mm_set1_epi8(9)), _mm_set1_epi8(9)));
+  const unsigned separatorMask =
+      _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, separators));
+
+  if ((digitMask & digitBits) != digitBits ||
+      (separatorMask & separatorBits) != separatorBits) {
+    return false;
+  }
+
+  // Widen to 16 bits and fold digit pairs with madd; separator lanes are
+  // weighted by zero.
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(digits, zero),
+                                     _mm_setr_epi16(1000, 100, 10, 1, 0, 10,
+                                                    1, 0));
+  const __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(digits, zero),
+                                      _mm_setr_epi16(10, 1, 0, 10, 1, 0, 10,
+                                                     1));
+
+  int32_t lanes[8];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), low);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes + 4), high);
+
+  year = lanes[0] + lanes[1];
+  month = lanes[2] + lanes[3];
+  day = lanes[4];
+  hour = lanes[5] + lanes[6];
+  minute = lanes[7];
+#else
+  for (size_t i = 0; i < 16; ++i) {
+    const bool separator = i == 4 || i == 7 || i == 10 || i == 13;
+    if (!separator && static_cast<unsigned>(begin[i] - '0') > 9) {
+      return false;
+    }
+  }
+
+  if (begin[4] != '-' || begin[7] != '-' || begin[10] != 'T' ||
+      begin[13] != ':') {
+    return false;
+  }
+
+  year = (begin[0] - '0') * 1000 + (begin[1] - '0') * 100 +
+         (begin[2] - '0') * 10 + (begin[3] - '0');
+  month = (begin[5] - '0') * 10 + (begin[6] - '0');
+  day = (begin[8] - '0') * 10 + (begin[9] - '0');
+  hour = (begin[11] - '0') * 10 + (begin[12] - '0');
+  minute = (begin[14] - '0') * 10 + (begin[15] - '0');
+#endif
+
+  const unsigned secondTens = static_cast<unsigned char>(begin[17]) - '0';
+  const unsigned secondOnes = static_cast<unsigned char>(begin[18]) - '0';
+  if (begin[16] != ':' || secondTens > 9 || secondOnes > 9) {
+    return false;
+  }
+  second = secondTens * 10 + secondOnes;
+
+  if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 ||
+      minute > 59 || second > 60) {
+    return false;
+  }
+
+  epoch = DateTimeProcessor::daysFromCivil(year, month, day) * SECONDS_IN_DAY +
+          hour * SECONDS_IN_HOUR + minute * 60 + second;
+
+  return true;
+}
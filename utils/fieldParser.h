@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// Fast parsers for the dataset's fixed-format fields. Both return false for
+// a missing (empty) or malformed field instead of throwing, so the caller
+// can record a gap. Results are bit-identical to strtof / DateTimeProcessor.
+class FieldParser {
+public:
+  // limit is the end of readable memory; when at least 16 bytes are
+  // readable the digits are validated with SSE2.
+  static bool parseFloat(const char *begin, const char *end,
+                         const char *limit, float &value);
+  static bool parseFloat(const char *begin, const char *end, float &value) {
+    return parseFloat(begin, end, end, value);
+  }
+
+  // Fixed-width "YYYY-MM-DDTHH:MM:SS" prefix, trailing 'Z' is optional.
+  static bool parseTimestamp(const char *begin, const char *end,
+                             int64_t &epoch);
+
+private:
+  static bool parseFloatFallback(const char *begin, const char *end,
+                                 float &value);
+};
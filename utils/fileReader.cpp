@@ -1,6 +1,11 @@
 #include "./fileReader.h"
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
 #include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -44,3 +49,76 @@ vector<string> FileReader::tokenise(const string &csv_line, char separator) {
   return tokens;
 }
 
+MappedFile::MappedFile(const string &path)
+    : opened(false), begin(nullptr), length(0) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) == 0) {
+    opened = true;
+    length = info.st_size;
+  }
+
+  if (opened && length > 0) {
+    void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      opened = false;
+      length = 0;
+    } else {
+      madvise(mapping, length, MADV_SEQUENTIAL);
+      begin = static_cast<const char *>(mapping);
+    }
+  }
+
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (begin != nullptr) {
+    munmap(const_cast<char *>(begin), length);
+  }
+}
+
+bool FileReader::nextLine(const char *&cursor, const char *end,
+                          StringSpan &line) {
+  if (cursor >= end) {
+    return false;
+  }
+
+  const char *newline =
+      static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+  const char *lineEnd = newline != nullptr ? newline : end;
+
+  line = StringSpan(cursor, lineEnd - cursor);
+  if (!line.empty() && line.data[line.size - 1] == '\r') {
+    --line.size;
+  }
+
+  cursor = newline != nullptr ? newline + 1 : end;
+
+  return true;
+}
+
+void FileReader::tokenise(const StringSpan &csvLine, char separator,
+                          vector<StringSpan> &tokens) {
+  tokens.clear();
+
+  const char *start = csvLine.data;
+  const char *end = csvLine.end();
+
+  while (true) {
+    const char *found =
+        static_cast<const char *>(memchr(start, separator, end - start));
+
+    if (found == nullptr) {
+      tokens.emplace_back(start, end - start);
+      break;
+    }
+
+    tokens.emplace_back(start, found - start);
+    start = found + 1;
+  }
+}
@@ -1,11 +1,55 @@
+#pragma once
+
+#include <cstddef>
 #include <string>
 #include <vector>
 
 using namespace std;
 
+// STREAM copies every line into a string (the original path), MAPPED maps the
+// file and hands out spans pointing straight into the mapping.
+enum class ReadMode { STREAM, MAPPED };
+
+class StringSpan {
+public:
+  StringSpan() : data(nullptr), size(0) {}
+  StringSpan(const char *_data, size_t _size) : data(_data), size(_size) {}
+
+  bool empty() const { return size == 0; }
+  const char *end() const { return data + size; }
+  string toString() const { return string(data, size); }
+
+  const char *data;
+  size_t size;
+};
+
+class MappedFile {
+public:
+  explicit MappedFile(const string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool isOpen() const { return opened; }
+  const char *data() const { return begin; }
+  size_t size() const { return length; }
+
+private:
+  bool opened;
+  const char *begin;
+  size_t length;
+};
+
 class FileReader {
 private:
 public:
   static vector<string> read_file(const string &path);
   static vector<string> tokenise(const string &csvLine, char separator);
+
+  // Zero-copy helpers used by the MAPPED path. nextLine advances cursor past
+  // the returned line, tokenise reuses the caller's vector between rows.
+  static bool nextLine(const char *&cursor, const char *end, StringSpan &line);
+  static void tokenise(const StringSpan &csvLine, char separator,
+                       vector<StringSpan> &tokens);
 };
@@ -0,0 +1,239 @@
+#include "simdReduction.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+typedef FloatSummary (*ReductionKernel)(const float *, size_t, float, float);
+
+static const float POSITIVE_INFINITY = numeric_limits<float>::infinity();
+
+FloatSummary::FloatSummary()
+    : first(numeric_limits<float>::quiet_NaN()), lowest(POSITIVE_INFINITY),
+      highest(-POSITIVE_INFINITY), sum(0), count(0) {}
+
+void FloatSummary::merge(const FloatSummary &other) {
+  if (other.count == 0) {
+    return;
+  }
+
+  if (count == 0) {
+    first = other.first;
+  }
+
+  lowest = min(lowest, other.lowest);
+  highest = max(highest, other.highest);
+  sum += other.sum;
+  count += other.count;
+}
+
+// NaN fails both comparisons, so missing values never pass.
+static bool isPresent(float value, float lowest, float highest) {
+  return value >= lowest && value <= highest;
+}
+
+// Skips the leading values that do not pass, which also settles first.
+static size_t findFirst(const float *values, size_t count, float lowest,
+                        float highest, FloatSummary &summary) {
+  size_t i = 0;
+  while (i < count && !isPresent(values[i], lowest, highest)) {
+    ++i;
+  }
+
+  if (i < count) {
+    summary.first = values[i];
+  }
+
+  return i;
+}
+
+static void summarizeTail(const float *values, size_t begin, size_t end,
+                          float lowest, float highest,
+                          FloatSummary &summary) {
+  for (size_t i = begin; i < end; ++i) {
+    const float value = values[i];
+    if (!isPresent(value, lowest, highest)) {
+      continue;
+    }
+
+    summary.lowest = min(summary.lowest, value);
+    summary.highest = max(summary.highest, value);
+    summary.sum += value;
+    ++summary.count;
+  }
+}
+
+FloatSummary SimdReduction::summarizeScalar(const float *values, size_t count,
+                                            float lowest, float highest) {
+  FloatSummary summary{};
+  summarizeTail(values, findFirst(values, count, lowest, highest, summary),
+                count, lowest, highest, summary);
+  return summary;
+}
+
+#ifdef __SSE2__
+
+// Lanes that fail the bounds are replaced by infinities before minps and
+// maxps and by zero before the sum; the passing mask, all ones or -1 per
+// lane, is subtracted to count them.
+FloatSummary SimdReduction::summarizeSse2(const float *values, size_t count,
+                                          float lowest, float highest) {
+  FloatSummary summary{};
+  size_t i = findFirst(values, count, lowest, highest, summary);
+
+  if (i + 4 <= count) {
+    const __m128 lowerBound = _mm_set1_ps(lowest);
+    const __m128 upperBound = _mm_set1_ps(highest);
+    const __m128 infinity = _mm_set1_ps(POSITIVE_INFINITY);
+    const __m128 negativeInfinity = _mm_set1_ps(-POSITIVE_INFINITY);
+
+    __m128 lowestLanes = infinity;
+    __m128 highestLanes = negativeInfinity;
+    __m128d sumLow = _mm_setzero_pd();
+    __m128d sumHigh = _mm_setzero_pd();
+    __m128i present = _mm_setzero_si128();
+
+    for (; i + 4 <= count; i += 4) {
+      const __m128 value = _mm_loadu_ps(values + i);
+      const __m128 passed = _mm_and_ps(_mm_cmpge_ps(value, lowerBound),
+                                       _mm_cmple_ps(value, upperBound));
+      const __m128 masked = _mm_and_ps(value, passed);
+
+      lowestLanes = _mm_min_ps(
+          lowestLanes, _mm_or_ps(masked, _mm_andnot_ps(passed, infinity)));
+      highestLanes = _mm_max_ps(
+          highestLanes,
+          _mm_or_ps(masked, _mm_andnot_ps(passed, negativeInfinity)));
+      sumLow = _mm_add_pd(sumLow, _mm_cvtps_pd(masked));
+      sumHigh =
+          _mm_add_pd(sumHigh, _mm_cvtps_pd(_mm_movehl_ps(masked, masked)));
+      present = _mm_sub_epi32(present, _mm_castps_si128(passed));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, lowestLanes);
+    summary.lowest = *min_element(lanes, lanes + 4);
+    _mm_storeu_ps(lanes, highestLanes);
+    summary.highest = *max_element(lanes, lanes + 4);
+
+    double sums[2];
+    _mm_storeu_pd(sums, _mm_add_pd(sumLow, sumHigh));
+    summary.sum = sums[0] + sums[1];
+
+    int counts[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(counts), present);
+    summary.count = static_cast<size_t>(counts[0]) + counts[1] + counts[2] +
+                    counts[3];
+  }
+
+  summarizeTail(values, i, count, lowest, highest, summary);
+  return summary;
+}
+
+// Short spans never touch the ymm registers, and zeroupper is explicit: the
+// compiler does not add it to a target("avx2") function, and without it
+// every return to SSE code pays a transition stall.
+__attribute__((target("avx2"))) FloatSummary
+SimdReduction::summarizeAvx2(const float *values, size_t count, float lowest,
+                             float highest) {
+  FloatSummary summary{};
+  size_t i = findFirst(values, count, lowest, highest, summary);
+
+  if (i + 8 <= count) {
+    const __m256 lowerBound = _mm256_set1_ps(lowest);
+    const __m256 upperBound = _mm256_set1_ps(highest);
+    const __m256 infinity = _mm256_set1_ps(POSITIVE_INFINITY);
+    const __m256 negativeInfinity = _mm256_set1_ps(-POSITIVE_INFINITY);
+
+    __m256 lowestLanes = infinity;
+    __m256 highestLanes = negativeInfinity;
+    __m256d sumLow = _mm256_setzero_pd();
+    __m256d sumHigh = _mm256_setzero_pd();
+    __m256i present = _mm256_setzero_si256();
+
+    for (; i + 8 <= count; i += 8) {
+      const __m256 value = _mm256_loadu_ps(values + i);
+      const __m256 passed =
+          _mm256_and_ps(_mm256_cmp_ps(value, lowerBound, _CMP_GE_OQ),
+                        _mm256_cmp_ps(value, upperBound, _CMP_LE_OQ));
+      const __m256 masked = _mm256_and_ps(value, passed);
+
+      lowestLanes = _mm256_min_ps(lowestLanes,
+                                  _mm256_blendv_ps(infinity, value, passed));
+      highestLanes = _mm256_max_ps(
+          highestLanes, _mm256_blendv_ps(negativeInfinity, value, passed));
+      sumLow = _mm256_add_pd(sumLow,
+                             _mm256_cvtps_pd(_mm256_castps256_ps128(masked)));
+      sumHigh = _mm256_add_pd(
+          sumHigh, _mm256_cvtps_pd(_mm256_extractf128_ps(masked, 1)));
+      present = _mm256_sub_epi32(present, _mm256_castps_si256(passed));
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, lowestLanes);
+    summary.lowest = *min_element(lanes, lanes + 8);
+    _mm256_storeu_ps(lanes, highestLanes);
+    summary.highest = *max_element(lanes, lanes + 8);
+
+    double sums[4];
+    _mm256_storeu_pd(sums, _mm256_add_pd(sumLow, sumHigh));
+    summary.sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+    int counts[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(counts), present);
+    for (int lane = 0; lane < 8; ++lane) {
+      summary.count += counts[lane];
+    }
+
+    _mm256_zeroupper();
+  }
+
+  summarizeTail(values, i, count, lowest, highest, summary);
+  return summary;
+}
+
+#endif
+
+static ReductionKernel selectKernel() {
+#ifdef __SSE2__
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdReduction::summarizeAvx2;
+  }
+
+  return SimdReduction::summarizeSse2;
+#else
+  return SimdReduction::summarizeScalar;
+#endif
+}
+
+static ReductionKernel kernel() {
+  static const ReductionKernel selected = selectKernel();
+  return selected;
+}
+
+FloatSummary SimdReduction::summarize(const float *values, size_t count) {
+  return kernel()(values, count, -POSITIVE_INFINITY, POSITIVE_INFINITY);
+}
+
+FloatSummary SimdReduction::summarize(const float *values, size_t count,
+                                      float lowest, float highest) {
+  return kernel()(values, count, lowest, highest);
+}
+
+const char *SimdReduction::implementation() {
+#ifdef __SSE2__
+  if (kernel() == SimdReduction::summarizeAvx2) {
+    return "avx2";
+  }
+
+  if (kernel() == SimdReduction::summarizeSse2) {
+    return "sse2";
+  }
+#endif
+
+  return "scalar";
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+using namespace std;
+
+// Reduction of the present values of a run of floats; NaN marks a missing
+// reading and is left out. first is the first present value.
+class FloatSummary {
+public:
+  FloatSummary();
+
+  float first;
+  float lowest;
+  float highest;
+  double sum;
+  size_t count;
+
+  // Folds in a summary of the values that follow this one's.
+  void merge(const FloatSummary &other);
+};
+
+// One-pass min / max / sum / count over contiguous floats. The kernel is
+// picked once at run time: AVX2 when the CPU has it, otherwise SSE2, or a
+// scalar loop off x86. Sums are kept in double, so the result only differs
+// between kernels in the last bits of sum.
+class SimdReduction {
+public:
+  static FloatSummary summarize(const float *values, size_t count);
+  // Only values in [lowest, highest] count as present; the bounds test
+  // is fused into the same pass, and NaN never passes it.
+  static FloatSummary summarize(const float *values, size_t count,
+                                float lowest, float highest);
+  static const char *implementation();
+
+  static FloatSummary summarizeScalar(const float *values, size_t count,
+                                      float lowest, float highest);
+#ifdef __SSE2__
+  static FloatSummary summarizeSse2(const float *values, size_t count,
+                                    float lowest, float highest);
+  static FloatSummary summarizeAvx2(const float *values, size_t count,
+                                    float lowest, float highest);
+#endif
+};